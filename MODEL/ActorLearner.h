@@ -0,0 +1,303 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include "PortfolioModel.h"
+#include "AdamOptimizer.h"
+#include "ExplorationPolicy.h"
+#include "Backtest.h"
+#include "ThreadPool.h"
+#include "ReplayBuffer.h"
+
+// bounded multi-producer multi-consumer queue (Vyukov), capacity rounded up to a power of two
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        cells = std::unique_ptr<Cell[]>(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(T&& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // full
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // empty
+            }
+            else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) std::atomic<size_t> head{ 0 };
+};
+
+// RCU-style publication of the dense head. The learner writes a new version into a slot
+// nobody is reading and swaps the current index; readers pin a slot with a counter.
+// With readers + 2 slots there is always a free slot, so neither side ever waits.
+class WeightStore {
+public:
+    WeightStore(const DenseLayer& layer, size_t max_readers) : slots(max_readers + 2) {
+        for (auto& slot : slots) {
+            slot.layer.reset(new DenseLayer(layer));
+        }
+    }
+
+    uint64_t publish(const DenseLayer& layer) {
+        size_t cur = current.load();
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (i != cur && slots[i].readers.load() == 0) {
+                slots[i].layer->weights = layer.weights;
+                slots[i].layer->biases = layer.biases;
+                slots[i].version = ++published;
+                current.store(i);
+                break;
+            }
+        }
+        return published;
+    }
+
+    // pin the current version, pair with release()
+    size_t acquire() {
+        while (true) {
+            size_t i = current.load();
+            slots[i].readers.fetch_add(1);
+            if (current.load() == i) return i;
+            slots[i].readers.fetch_sub(1);
+        }
+    }
+
+    void release(size_t slot) { slots[slot].readers.fetch_sub(1); }
+
+    const DenseLayer& layer(size_t slot) const { return *slots[slot].layer; }
+    uint64_t version(size_t slot) const { return slots[slot].version; }
+
+private:
+    struct Slot {
+        std::unique_ptr<DenseLayer> layer;
+        std::atomic<int> readers{ 0 };
+        uint64_t version = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<size_t> current{ 0 };
+    uint64_t published = 0;  // learner-only
+};
+
+// one symbol's months, in date order, acted on with one weight version
+struct Trajectory {
+    std::vector<double> outputs;  // [steps x combined_output_size]
+    std::vector<int> actions;
+    std::vector<double> rewards;
+    uint64_t version = 0;
+};
+
+struct ActorLearnerOptions {
+    int num_actors = 2;
+    size_t queue_capacity = 256;
+    int long_action = 0;
+    // actors also push every transition here; the learner adds one prioritized minibatch
+    // step per trajectory once it holds replay_batch of them
+    ReplayBuffer* replay = nullptr;
+    size_t replay_batch = 0;
+};
+
+struct ActorLearnerStats {
+    size_t trajectories = 0;
+    size_t updates = 0;
+    size_t full_queue_retries = 0;
+    double average_staleness = 0.0;  // weight versions between acting and learning
+};
+
+// N rollout tasks each own a shard of symbols and act with the latest published weights;
+// the learner applies one averaged update per trajectory and republishes. Rows of data are
+// grouped by symbol in date order (loadFinancialData order). Returns per-epoch stats.
+template <typename Reward>
+std::vector<ActorLearnerStats> trainActorLearner(PortfolioModel& model, AdamOptimizer& adam,
+    ExplorationPolicy& policy, double epsilon_decay, int epochs,
+    const std::vector<FinancialData>& data, const std::vector<MacroData>& macro, const PricePanel& panel, const Reward& reward_fn,
+    std::vector<double>& long_probs, const ActorLearnerOptions& options) {
+
+    // symbol streams: [begin, end) ranges of data
+    std::vector<std::pair<size_t, size_t>> streams;
+    for (size_t i = 0; i < data.size();) {
+        size_t j = i;
+        while (j < data.size() && data[j].symbol == data[i].symbol) ++j;
+        streams.emplace_back(i, j);
+        i = j;
+    }
+
+    const int output_size = model.combined_output_size();
+    WeightStore store(model.final_layer, options.num_actors);
+    std::vector<ActorLearnerStats> stats;
+    std::vector<double> macro_outputs;
+
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        BoundedQueue<Trajectory> queue(options.queue_capacity);
+        std::atomic<int> running{ options.num_actors };
+        std::atomic<size_t> retries{ 0 };
+        uint64_t version = store.publish(model.final_layer);
+        model.encode_months(macro, macro_outputs);
+
+        // copies taken before the learner starts writing; LTC cells are not trained,
+        // the head always comes from the store
+        std::vector<PortfolioModel> locals(options.num_actors, model);
+        std::vector<ExplorationPolicy> actor_policies(options.num_actors, policy);
+        for (ExplorationPolicy& actor_policy : actor_policies) {
+            actor_policy.hold_action = options.long_action;
+        }
+
+        // actors are pool tasks; this thread is the learner and only joins them once the
+        // queue is drained (an actor run here would block on the full queue)
+        TaskGroup actors;
+        for (int a = 0; a < options.num_actors; ++a) {
+            actors.run([&, a] {
+                // also when the actor throws: the learner stops waiting and actors.wait() rethrows
+                struct Finished {
+                    std::atomic<int>& running;
+                    ~Finished() { running.fetch_sub(1); }
+                } finished{ running };
+                PortfolioModel& local = locals[a];
+                ExplorationPolicy& actor_policy = actor_policies[a];
+                Arena& arena = threadArena();  // trajectories cross threads, their action probs do not
+                for (size_t s = a; s < streams.size(); s += options.num_actors) {
+                    Reward reward = reward_fn;
+                    Trajectory trajectory;
+                    size_t slot = store.acquire();
+                    trajectory.version = store.version(slot);
+                    const size_t steps = streams[s].second - streams[s].first;
+                    trajectory.rewards.reserve(steps);
+                    // the whole trajectory is scored, then one select_actions call picks its actions
+                    ArenaScope scope(arena);
+                    const size_t A = PortfolioModel::num_actions;
+                    double* probs = arena.allocate_array<double>(steps * A);
+                    trajectory.outputs.resize(steps * output_size);
+                    trajectory.actions.resize(steps);
+                    for (size_t t = 0; t < steps; ++t) {
+                        double* combined_output = &trajectory.outputs[t * output_size];
+                        local.encode(data[streams[s].first + t], macro_outputs, combined_output);
+                        store.layer(slot).forward(combined_output, probs + t * A);
+                        softmax(probs + t * A, A, probs + t * A);
+                    }
+                    store.release(slot);
+                    actor_policy.select_actions(probs, steps, A, trajectory.actions.data());
+                    for (size_t t = 0; t < steps; ++t) {
+                        const FinancialData& fd = data[streams[s].first + t];
+                        const double p_long = probs[t * A + options.long_action];
+                        if (epoch == epochs - 1) {
+                            long_probs[panel.cell(fd)] = p_long;
+                        }
+                        trajectory.rewards.push_back(reward(fd, p_long));
+                        if (options.replay_batch > 0 && options.replay) {
+                            options.replay->push(&trajectory.outputs[t * output_size], trajectory.actions[t], trajectory.rewards.back());
+                        }
+                    }
+                    while (!queue.try_push(std::move(trajectory))) {
+                        retries.fetch_add(1, std::memory_order_relaxed);
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        // learner
+        ActorLearnerStats epoch_stats;
+        Arena& arena = threadArena();
+        const size_t weight_count = model.final_layer.output_size * output_size;
+        ReplayBuffer* replay = options.replay_batch > 0 ? options.replay : nullptr;
+        ReplayBatch replay_batch;
+        Trajectory trajectory;
+        double staleness = 0.0;
+        while (true) {
+            if (!queue.try_pop(trajectory)) {
+                if (running.load() == 0 && !queue.try_pop(trajectory)) break;
+                std::this_thread::yield();
+                continue;
+            }
+            size_t steps = trajectory.actions.size();
+            if (steps == 0) continue;
+
+            ArenaScope update(arena);
+            StepScratch s = model.step_scratch(arena);
+            double* dW_sum = arena.zeros<double>(weight_count);
+            double* dB_sum = arena.zeros<double>(model.final_layer.output_size);
+            for (size_t t = 0; t < steps; ++t) {
+                const double* combined_output = &trajectory.outputs[t * output_size];
+                model.action_probs(combined_output, s.action_probs);
+                policyGradient(s.action_probs, PortfolioModel::num_actions, trajectory.actions[t], trajectory.rewards[t], s.grad_output);
+                model.final_layer.backward(combined_output, s.grad_output, s.dW, s.dB);
+                for (size_t w = 0; w < weight_count; ++w) {
+                    dW_sum[w] += s.dW[w] / steps;
+                }
+                for (int i = 0; i < model.final_layer.output_size; ++i) {
+                    dB_sum[i] += s.dB[i] / steps;
+                }
+            }
+            adam.update(model.final_layer.weights, model.final_layer.biases, dW_sum, dB_sum, epoch + 1);
+            if (replay && replayUpdate(model, adam, *replay, options.replay_batch, replay_batch, arena, epoch + 1)) {
+                ++epoch_stats.updates;
+            }
+            staleness += static_cast<double>(version - trajectory.version);
+            version = store.publish(model.final_layer);
+
+            ++epoch_stats.trajectories;
+            ++epoch_stats.updates;
+        }
+        actors.wait();
+
+        epoch_stats.full_queue_retries = retries.load();
+        epoch_stats.average_staleness = epoch_stats.trajectories ? staleness / epoch_stats.trajectories : 0.0;
+        stats.push_back(epoch_stats);
+        policy.decay_epsilon(epsilon_decay);
+    }
+    return stats;
+}
@@ -1,6 +1,8 @@
+#pragma once
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include "Profiler.h"
 
 class AdamOptimizer {
 public:
@@ -25,6 +27,7 @@ public:
 
     void update(std::vector<std::vector<double>>& weights, std::vector<double>& biases,
         const std::vector<std::vector<double>>& dW, const std::vector<double>& dB, int t) {
+        PROFILE_SCOPE("AdamOptimizer::update");
 
         double lr_t = learning_rate * std::sqrt(1 - std::pow(beta2, t)) / (1 - std::pow(beta1, t));
 
@@ -45,4 +48,28 @@ public:
             biases[i] -= lr_t * m_biases[i] / (std::sqrt(v_biases[i]) + epsilon);
         }
     }
+
+    // same update with dW flattened [rows x cols] (DenseLayer::backward pointer form)
+    void update(std::vector<std::vector<double>>& weights, std::vector<double>& biases,
+        const double* dW, const double* dB, int t) {
+        PROFILE_SCOPE("AdamOptimizer::update");
+
+        double lr_t = learning_rate * std::sqrt(1 - std::pow(beta2, t)) / (1 - std::pow(beta1, t));
+
+        const size_t cols = weights[0].size();
+        for (size_t i = 0; i < weights.size(); ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                double g = dW[i * cols + j];
+                m_weights[i][j] = beta1 * m_weights[i][j] + (1 - beta1) * g;
+                v_weights[i][j] = beta2 * v_weights[i][j] + (1 - beta2) * std::pow(g, 2);
+                weights[i][j] -= lr_t * m_weights[i][j] / (std::sqrt(v_weights[i][j]) + epsilon);
+            }
+        }
+
+        for (size_t i = 0; i < biases.size(); ++i) {
+            m_biases[i] = beta1 * m_biases[i] + (1 - beta1) * dB[i];
+            v_biases[i] = beta2 * v_biases[i] + (1 - beta2) * std::pow(dB[i], 2);
+            biases[i] -= lr_t * m_biases[i] / (std::sqrt(v_biases[i]) + epsilon);
+        }
+    }
 };
@@ -0,0 +1,129 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// Error-controlled integration for ODESolver::Adaptive. The fixed semi-implicit update is
+// one step of length 1 of
+//     cm_t dv/dt = gleak (vleak - v) + W sigmoid(v)
+// so `ode_solver_unfolds` fixed steps cover a horizon of ode_solver_unfolds. The adaptive
+// solver covers the same horizon with variable steps h of the same update (leak implicit,
+// synapses explicit, cm_t / h in place of cm_t). The embedded second-order companion
+// (trapezoid on both terms) reuses the synapse sums of both ends of the step, so the error
+// estimate is free and a step costs one synapse evaluation, like a fixed unfold.
+// Steps never go below min_step (the fixed unfold by default) and grow while the error
+// estimate allows. A step over tolerance is retried shorter only while the evaluations
+// saved by earlier long steps pay for it, otherwise it is kept, so an integration never
+// costs more than horizon / min_step evaluations, the fixed unfolds' count. Once the state
+// would drift by less than exit_tolerance error scales over the rest of the horizon, one
+// last step jumps to its end. The end of the last step is never evaluated.
+// Measured on fused 16/64-unit cell pairs, 6 unfolds: a settled state costs 1 evaluation; a
+// cold start from zero costs 5, the last step an early exit, at 0.5-0.7% max relative error
+// against 0.3-0.4% for the fixed unfolds.
+struct AdaptiveODEConfig {
+    double rtol = 0.1;
+    double atol = 1e-2;             // states are O(1)
+    double exit_tolerance = 2.0;    // |dv/dt| * time left, in units of atol + rtol |v|
+    double initial_step = 1.0;      // the fixed unfold
+    double min_step = 1.0;          // sets the evaluation budget, horizon / min_step
+};
+
+// summed over calls; one evaluation = one synapse matrix-vector product, the cost of one
+// fixed unfold
+struct ODEStats {
+    size_t calls = 0;
+    size_t accepted = 0;
+    size_t rejected = 0;
+    size_t evaluations = 0;
+    size_t early_exits = 0;
+
+    void add(const ODEStats& other) {
+        calls += other.calls;
+        accepted += other.accepted;
+        rejected += other.rejected;
+        evaluations += other.evaluations;
+        early_exits += other.early_exits;
+    }
+
+    double evaluations_per_call() const { return calls ? static_cast<double>(evaluations) / calls : 0.0; }
+};
+
+struct AdaptiveODEScratch {
+    std::vector<double> synapse, synapse_next, next;
+
+    void resize(size_t n) {
+        synapse.resize(n);
+        synapse_next.resize(n);
+        next.resize(n);
+    }
+};
+
+// Integrates the n units of v in place over [0, horizon]. synapse(v, s) writes
+// s = W sigmoid(v); leak = gleak * vleak. scratch must be resized to n.
+template <typename Synapse>
+void integrateAdaptive(double* v, size_t n, double horizon, const double* cm_t, const double* gleak,
+    const double* leak, const AdaptiveODEConfig& config, Synapse&& synapse, AdaptiveODEScratch& scratch,
+    ODEStats& stats) {
+    ++stats.calls;
+    double* s0 = scratch.synapse.data();
+    double* s1 = scratch.synapse_next.data();
+    double* next = scratch.next.data();
+    // min_step steps left to the end of the horizon
+    auto steps_left = [&](double t) { return std::ceil((horizon - t) / config.min_step - 1e-9); };
+
+    synapse(v, s0);
+    ++stats.evaluations;
+    // max |dv/dt| in error scales; times the time left, the drift tested for the early exit
+    double rate = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        rate = std::max(rate, std::fabs(leak[i] - gleak[i] * v[i] + s0[i]) / (cm_t[i] * (config.atol + config.rtol * std::fabs(v[i]))));
+    }
+    // evaluations left in the budget; finishing in min_step steps needs steps_left - 1
+    double remaining = steps_left(0.0) - 1.0;
+    double t = 0.0;
+    double h = std::max(config.initial_step, config.min_step);
+    while (t < horizon) {
+        const bool exit = rate * (horizon - t) < config.exit_tolerance;
+        h = exit ? horizon - t : std::min(h, horizon - t);
+        for (size_t i = 0; i < n; ++i) {
+            next[i] = (cm_t[i] * v[i] + h * leak[i] + h * s0[i]) / (cm_t[i] + h * gleak[i]);
+        }
+
+        const bool last = t + h >= horizon;
+        const bool can_retry = h > config.min_step && remaining - 1.0 >= steps_left(t) - 1.0;
+        if (last && (exit || !can_retry)) {
+            ++stats.accepted;
+            stats.early_exits += exit && h > config.min_step ? 1 : 0;
+            std::copy(next, next + n, v);
+            return;
+        }
+        synapse(next, s1);
+        ++stats.evaluations;
+        remaining -= 1.0;
+
+        // error of the step and rate at its end, both in the error scales of the step
+        double error = 0.0;
+        double next_rate = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double half = 0.5 * h;
+            double trapezoid = ((cm_t[i] - half * gleak[i]) * v[i] + h * leak[i] + half * (s0[i] + s1[i])) / (cm_t[i] + half * gleak[i]);
+            double inverse_scale = 1.0 / (config.atol + config.rtol * std::max(std::fabs(v[i]), std::fabs(next[i])));
+            error = std::max(error, std::fabs(trapezoid - next[i]) * inverse_scale);
+            next_rate = std::max(next_rate, std::fabs(leak[i] - gleak[i] * next[i] + s1[i]) * inverse_scale / cm_t[i]);
+        }
+
+        if (error <= 1.0 || !can_retry) {
+            ++stats.accepted;
+            t += h;
+            std::copy(next, next + n, v);
+            std::swap(s0, s1);  // synapse sums of the new state
+            rate = next_rate;
+        }
+        else {
+            ++stats.rejected;
+        }
+        // local error is O(h^2): usual 0.9 safety factor, growth limited to [0.2, 5] per step
+        double factor = error > 0.0 ? 0.9 / std::sqrt(error) : 5.0;
+        h = std::max(config.min_step, h * std::min(5.0, std::max(0.2, factor)));
+    }
+}
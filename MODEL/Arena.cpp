@@ -0,0 +1,62 @@
+#include "Arena.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocation_calls{ 0 };
+std::atomic<uint64_t> allocation_bytes{ 0 };
+
+}
+
+namespace allocation {
+
+Counts counts() {
+    Counts c;
+    c.calls = allocation_calls.load(std::memory_order_relaxed);
+    c.bytes = allocation_bytes.load(std::memory_order_relaxed);
+    return c;
+}
+
+void summary(std::ostream& out, const std::string& label) {
+    static Counts last;
+    Counts now = counts();
+    out << label << " - Allocations: " << now.calls - last.calls << " calls, " << now.bytes - last.bytes
+        << " bytes - Arena peak: " << threadArena().peak() << " bytes" << std::endl;
+    last = counts();  // the summary's own allocations belong to the next period
+}
+
+}
+
+#ifdef PORTFOLIO_TRACK_ALLOCATIONS
+
+void* operator new(std::size_t size) {
+    allocation_calls.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocation_calls.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <type_traits>
+#include <algorithm>
+
+// Monotonic bump allocator for the temporaries of one training step. allocate() moves a
+// pointer, nothing is freed individually; an ArenaScope rewinds to where it started when
+// the step ends. Blocks are kept across rewinds, so once the first step has sized the arena
+// the hot loop never reaches malloc.
+class Arena {
+public:
+    struct Marker {
+        size_t block;
+        size_t offset;
+        size_t used;
+    };
+
+    explicit Arena(size_t block_size = size_t(64) << 10) : block_size(block_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        if (blocks.empty() || !fits(blocks[current], offset, bytes, align)) {
+            next_block(bytes + align);
+        }
+        Block& b = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data.get());
+        uintptr_t p = (base + offset + align - 1) & ~(uintptr_t(align) - 1);
+        size_t end = static_cast<size_t>(p - base) + bytes;
+        used_ += end - offset;
+        peak_ = std::max(peak_, used_);
+        offset = end;
+        return reinterpret_cast<void*>(p);
+    }
+
+    // n uninitialized values; T is trivial, nothing is destroyed
+    template <typename T>
+    T* allocate_array(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena values are never destroyed");
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+    template <typename T>
+    T* zeros(size_t n) {
+        T* values = allocate_array<T>(n);
+        std::fill_n(values, n, T());
+        return values;
+    }
+
+    Marker mark() const { return { current, offset, used_ }; }
+    void rewind(const Marker& m) {
+        current = m.block;
+        offset = m.offset;
+        used_ = m.used;
+    }
+    void reset() { rewind({ 0, 0, 0 }); }
+
+    size_t used() const { return used_; }    // bytes handed out since the last reset, padding included
+    size_t peak() const { return peak_; }
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& b : blocks) total += b.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    static bool fits(const Block& b, size_t offset, size_t bytes, size_t align) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data.get());
+        uintptr_t p = (base + offset + align - 1) & ~(uintptr_t(align) - 1);
+        return static_cast<size_t>(p - base) + bytes <= b.size;
+    }
+
+    // the next kept block if it is large enough, else a new one (smaller ones are dropped)
+    void next_block(size_t bytes) {
+        size_t next = blocks.empty() ? 0 : current + 1;
+        while (next < blocks.size() && blocks[next].size < bytes) {
+            blocks.erase(blocks.begin() + next);
+        }
+        if (next == blocks.size()) {
+            size_t size = std::max(block_size, bytes);
+            blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[size]), size });
+        }
+        if (!blocks.empty() && next > 0) {
+            used_ += blocks[current].size - offset;  // the rest of the left block counts as used
+        }
+        current = next;
+        offset = 0;
+    }
+
+    size_t block_size;
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+    size_t used_ = 0;
+    size_t peak_ = 0;
+};
+
+// rewinds the arena to its state at construction
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena) : arena(arena), marker(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(marker); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena;
+    Arena::Marker marker;
+};
+
+// one arena per thread: pool workers (trials, folds, actors) each get their own
+inline Arena& threadArena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+// Allocation tracking (-DPORTFOLIO_TRACK_ALLOCATIONS=ON): global operator new is replaced to
+// count calls and bytes on every thread, and ALLOCATION_SUMMARY prints what was allocated
+// since the previous summary, e.g. once per epoch to check the row loop stays malloc-free.
+// Compiled out otherwise.
+namespace allocation {
+
+struct Counts {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+};
+
+Counts counts();  // since the start of the process, all threads
+void summary(std::ostream& out, const std::string& label);
+
+}
+
+#ifdef PORTFOLIO_TRACK_ALLOCATIONS
+#define ALLOCATION_SUMMARY(out, label) ::allocation::summary(out, label)
+#else
+#define ALLOCATION_SUMMARY(out, label) do {} while (0)
+#endif
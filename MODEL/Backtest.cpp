@@ -0,0 +1,136 @@
+#include "Backtest.h"
+#include <algorithm>
+#include <cmath>
+
+PricePanel buildPricePanel(const std::vector<FinancialData>& data) {
+    PricePanel panel;
+
+    // periods are already dense month indices, no date lookups
+    for (const auto& fd : data) {
+        if (static_cast<size_t>(fd.period) >= panel.dates.size()) {
+            panel.dates.resize(fd.period + 1);
+        }
+        panel.dates[fd.period] = fd.date;
+        if (panel.symbol_index.emplace(fd.symbol, panel.symbols.size()).second) {
+            panel.symbols.push_back(fd.symbol);
+        }
+    }
+
+    size_t cells = panel.num_periods() * panel.num_symbols();
+    panel.prices.assign(cells, 0.0);
+    panel.next_prices.assign(cells, 0.0);
+    for (const auto& fd : data) {
+        size_t c = panel.cell(fd);
+        panel.prices[c] = fd.stockPrice;
+        panel.next_prices[c] = fd.nextMonthStockPrice;
+    }
+    return panel;
+}
+
+void buildPortfolioWeights(const PricePanel& panel, const std::vector<double>& action_probs,
+    double min_probability, std::vector<double>& weights) {
+    const size_t n = panel.num_symbols();
+    weights.assign(panel.prices.size(), 0.0);
+
+    for (size_t t = 0; t < panel.num_periods(); ++t) {
+        const double* p = &action_probs[t * n];
+        const double* price = &panel.prices[t * n];
+        const double* next = &panel.next_prices[t * n];
+        double* w = &weights[t * n];
+
+        // masks instead of branches so the loop vectorizes
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double tradable = static_cast<double>((price[i] > 0.0) & (next[i] > 0.0) & (p[i] >= min_probability));
+            w[i] = p[i] * tradable;
+            sum += w[i];
+        }
+        double scale = sum > 0.0 ? 1.0 / sum : 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            w[i] *= scale;
+        }
+    }
+}
+
+BacktestResult runBacktest(const PricePanel& panel, const std::vector<double>& action_probs,
+    const BacktestConfig& config) {
+    BacktestResult result;
+    const size_t periods = panel.num_periods();
+    const size_t n = panel.num_symbols();
+    if (periods == 0 || n == 0 || action_probs.size() != panel.prices.size()) {
+        return result;
+    }
+
+    buildPortfolioWeights(panel, action_probs, config.min_probability, result.weights);
+
+    // asset returns, whole panel in one pass
+    std::vector<double> asset_returns(panel.prices.size());
+    for (size_t c = 0; c < asset_returns.size(); ++c) {
+        double valid = static_cast<double>((panel.prices[c] > 0.0) & (panel.next_prices[c] > 0.0));
+        asset_returns[c] = valid * (panel.next_prices[c] / (panel.prices[c] + (1.0 - valid)) - 1.0);
+    }
+
+    result.gross_returns.assign(periods, 0.0);
+    result.turnover.assign(periods, 0.0);
+    result.costs.assign(periods, 0.0);
+    result.net_returns.assign(periods, 0.0);
+
+    // weights held at the end of the previous period, after drifting with prices
+    std::vector<double> drifted(n, 0.0);
+    const double cost_rate = config.transaction_cost_bps / 10000.0;
+
+    for (size_t t = 0; t < periods; ++t) {
+        const double* w = &result.weights[t * n];
+        const double* r = &asset_returns[t * n];
+
+        double gross = 0.0;
+        double turnover = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            gross += w[i] * r[i];
+            turnover += std::fabs(w[i] - drifted[i]);
+        }
+
+        double growth = 1.0 + gross;
+        double inv_growth = growth != 0.0 ? 1.0 / growth : 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            drifted[i] = w[i] * (1.0 + r[i]) * inv_growth;
+        }
+
+        result.gross_returns[t] = gross;
+        result.turnover[t] = turnover;
+        result.costs[t] = turnover * cost_rate;
+        result.net_returns[t] = gross - result.costs[t];
+    }
+
+    result.equity.resize(periods);
+    result.drawdown.resize(periods);
+    double equity = 1.0;
+    double peak = 1.0;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (size_t t = 0; t < periods; ++t) {
+        double r = result.net_returns[t];
+        equity *= 1.0 + r;
+        peak = std::max(peak, equity);
+        result.equity[t] = equity;
+        result.drawdown[t] = equity / peak - 1.0;
+        result.max_drawdown = std::min(result.max_drawdown, result.drawdown[t]);
+        result.average_turnover += result.turnover[t];
+        result.total_costs += result.costs[t];
+        sum += r;
+        sum_sq += r * r;
+    }
+
+    double mean = sum / periods;
+    double variance = std::max(0.0, sum_sq / periods - mean * mean);
+    double years = periods / config.periods_per_year;
+
+    result.total_return = equity - 1.0;
+    result.annualized_return = equity > 0.0 ? std::pow(equity, 1.0 / years) - 1.0 : -1.0;
+    result.annualized_volatility = std::sqrt(variance * config.periods_per_year);
+    if (result.annualized_volatility != 0) {
+        result.sharpe = mean * config.periods_per_year / result.annualized_volatility;
+    }
+    result.average_turnover /= periods;
+    return result;
+}
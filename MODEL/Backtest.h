@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "FinancialData.h"
+
+// columnar price data, one row per month (FinancialData::period), one column per symbol
+struct PricePanel {
+    std::vector<std::string> dates;
+    std::vector<std::string> symbols;
+    std::vector<double> prices;       // [dates x symbols], 0.0 = no data
+    std::vector<double> next_prices;  // [dates x symbols]
+
+    std::unordered_map<std::string, size_t> symbol_index;
+
+    size_t num_periods() const { return dates.size(); }
+    size_t num_symbols() const { return symbols.size(); }
+
+    size_t cell(size_t period, size_t symbol) const { return period * symbols.size() + symbol; }
+    size_t cell(const FinancialData& fd) const {
+        return cell(static_cast<size_t>(fd.period), symbol_index.at(fd.symbol));
+    }
+};
+
+struct BacktestConfig {
+    double transaction_cost_bps = 10.0;  // cost per unit of turnover
+    double min_probability = 0.0;        // below this an asset is not held
+    double periods_per_year = 12.0;
+};
+
+struct BacktestResult {
+    std::vector<double> weights;        // [periods x symbols]
+    std::vector<double> gross_returns;  // per period
+    std::vector<double> turnover;
+    std::vector<double> costs;
+    std::vector<double> net_returns;
+    std::vector<double> equity;
+    std::vector<double> drawdown;
+
+    double total_return = 0.0;
+    double annualized_return = 0.0;
+    double annualized_volatility = 0.0;
+    double sharpe = 0.0;
+    double max_drawdown = 0.0;
+    double average_turnover = 0.0;
+    double total_costs = 0.0;
+};
+
+// must be called on raw prices, before normalizeData
+PricePanel buildPricePanel(const std::vector<FinancialData>& data);
+
+// long-only weights proportional to the probabilities, [periods x symbols]
+void buildPortfolioWeights(const PricePanel& panel, const std::vector<double>& action_probs,
+    double min_probability, std::vector<double>& weights);
+
+BacktestResult runBacktest(const PricePanel& panel, const std::vector<double>& action_probs,
+    const BacktestConfig& config);
@@ -0,0 +1,136 @@
+#include "BinaryDataset.h"
+#include "DataPreprocessing.h"
+#include "Profiler.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+std::vector<const FeatureField*> binaryRowFields() {
+    std::vector<const FeatureField*> fields;
+    for (const FeatureField& field : featureSchema) {
+        if (field.csv_column && field.row) fields.push_back(&field);
+    }
+    return fields;
+}
+
+std::vector<const FeatureField*> binaryMacroFields() {
+    std::vector<const FeatureField*> fields;
+    for (const FeatureField& field : featureSchema) {
+        if (field.csv_column && field.macro) fields.push_back(&field);
+    }
+    return fields;
+}
+
+BinaryDatasetHeader makeBinaryDatasetHeader(uint64_t num_symbols, uint64_t num_periods) {
+    BinaryDatasetHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, binaryDatasetMagic, sizeof(header.magic));
+    header.version = binaryDatasetVersion;
+    header.date_width = 16;
+    header.symbol_width = 16;
+    header.row_fields = static_cast<uint32_t>(binaryRowFields().size());
+    header.macro_fields = static_cast<uint32_t>(binaryMacroFields().size());
+    header.num_symbols = num_symbols;
+    header.num_periods = num_periods;
+    header.dates_offset = sizeof(BinaryDatasetHeader);
+    header.symbols_offset = header.dates_offset + num_periods * header.date_width;
+    header.macro_offset = header.symbols_offset + num_symbols * header.symbol_width;
+    header.rows_offset = header.macro_offset + num_periods * header.macro_fields * sizeof(double);
+    return header;
+}
+
+uint64_t binaryRowOffset(const BinaryDatasetHeader& header, uint64_t symbol, uint64_t period) {
+    return header.rows_offset + (symbol * header.num_periods + period) * header.row_fields * sizeof(double);
+}
+
+uint64_t binaryDatasetSize(const BinaryDatasetHeader& header) {
+    return binaryRowOffset(header, header.num_symbols, 0);
+}
+
+bool readBinaryDatasetHeader(std::istream& file, BinaryDatasetHeader& header) {
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    return file && std::memcmp(header.magic, binaryDatasetMagic, sizeof(header.magic)) == 0
+        && header.version == binaryDatasetVersion
+        && header.row_fields == binaryRowFields().size() && header.macro_fields == binaryMacroFields().size();
+}
+
+std::vector<std::string> readBinaryStrings(std::istream& file, uint64_t offset, uint64_t count, uint32_t width) {
+    std::vector<char> buffer(count * width);
+    file.seekg(offset);
+    file.read(buffer.data(), buffer.size());
+    std::vector<std::string> strings(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        const char* s = &buffer[i * width];
+        strings[i].assign(s, strnlen(s, width));
+    }
+    return strings;
+}
+
+std::vector<FinancialData> loadFinancialDataBinary(const std::string& filename, std::vector<MacroData>& macro) {
+    DataValidity validity;
+    return loadFinancialDataBinary(filename, macro, validity);
+}
+
+std::vector<FinancialData> loadFinancialDataBinary(const std::string& filename, std::vector<MacroData>& macro, DataValidity& validity) {
+    PROFILE_SCOPE("loadFinancialDataBinary");
+    validity.fields.clear();
+    std::vector<FinancialData> data;
+    macro.clear();
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Erreur lors de l'ouverture du fichier binaire." << std::endl;
+        return data;
+    }
+
+    BinaryDatasetHeader header;
+    const std::vector<const FeatureField*> row_fields = binaryRowFields();
+    const std::vector<const FeatureField*> macro_fields = binaryMacroFields();
+    if (!readBinaryDatasetHeader(file, header)) {
+        std::cerr << "Fichier binaire invalide: " << filename << std::endl;
+        return data;
+    }
+
+    std::vector<std::string> dates = readBinaryStrings(file, header.dates_offset, header.num_periods, header.date_width);
+    std::vector<std::string> symbols = readBinaryStrings(file, header.symbols_offset, header.num_symbols, header.symbol_width);
+
+    std::vector<double> values(header.num_periods * header.macro_fields);
+    file.seekg(header.macro_offset);
+    file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double));
+    macro.resize(header.num_periods);
+    for (uint64_t t = 0; t < header.num_periods; ++t) {
+        macro[t].date = dates[t];
+        for (size_t f = 0; f < macro_fields.size(); ++f) {
+            macro[t].*(macro_fields[f]->macro) = values[t * header.macro_fields + f];
+        }
+    }
+
+    // one symbol at a time, loader order: by symbol, then date
+    data.resize(header.num_symbols * header.num_periods);
+    values.resize(header.num_periods * header.row_fields);
+    file.seekg(header.rows_offset);
+    for (uint64_t s = 0; s < header.num_symbols; ++s) {
+        file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double));
+        if (!file) {
+            std::cerr << "Fichier binaire tronque: " << filename << std::endl;
+            data.resize(s * header.num_periods);
+            break;
+        }
+        FinancialData* records = &data[s * header.num_periods];
+        for (uint64_t t = 0; t < header.num_periods; ++t) {
+            FinancialData& fd = records[t];
+            fd.date = dates[t];
+            fd.symbol = symbols[s];
+            fd.period = static_cast<int>(t);
+            for (size_t f = 0; f < row_fields.size(); ++f) {
+                fd.*(row_fields[f]->row) = values[t * header.row_fields + f];
+            }
+        }
+        for (uint64_t t = 0; t < header.num_periods; ++t) {
+            records[t].nextMonthStockPrice = records[t + 1 < header.num_periods ? t + 1 : t].stockPrice;
+        }
+    }
+
+    extractValidity(data, macro, validity);
+    PROFILE_COUNT("binary.rows", data.size());
+    return data;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "FinancialData.h"
+#include "FeatureSchema.h"
+
+// Binary twin of financial_data.csv: a fixed header, the date and symbol tables, one
+// macro row per date and then every (symbol, date) row, symbol-major. All symbols cover
+// all dates, so a row lives at a computable offset and writers can fill the file in
+// parallel. Values are native-endian doubles in featureSchema order, NaN = missing.
+struct BinaryDatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t date_width;    // bytes per date, NUL padded
+    uint32_t symbol_width;  // bytes per symbol, NUL padded
+    uint32_t row_fields;    // stored FinancialData columns
+    uint32_t macro_fields;  // stored MacroData columns
+    uint32_t reserved;
+    uint64_t num_symbols;
+    uint64_t num_periods;
+    uint64_t dates_offset;
+    uint64_t symbols_offset;
+    uint64_t macro_offset;
+    uint64_t rows_offset;
+};
+
+constexpr char binaryDatasetMagic[8] = { 'P', 'F', 'D', 'A', 'T', 'A', 0, 1 };
+constexpr uint32_t binaryDatasetVersion = 1;
+
+// schema fields stored per row / per date (the CSV columns)
+std::vector<const FeatureField*> binaryRowFields();
+std::vector<const FeatureField*> binaryMacroFields();
+
+BinaryDatasetHeader makeBinaryDatasetHeader(uint64_t num_symbols, uint64_t num_periods);
+uint64_t binaryDatasetSize(const BinaryDatasetHeader& header);
+uint64_t binaryRowOffset(const BinaryDatasetHeader& header, uint64_t symbol, uint64_t period);
+
+// reads and checks the header (magic, version, field counts) at the stream's position
+bool readBinaryDatasetHeader(std::istream& file, BinaryDatasetHeader& header);
+// the date or symbol table, NUL padding stripped
+std::vector<std::string> readBinaryStrings(std::istream& file, uint64_t offset, uint64_t count, uint32_t width);
+
+// same result as loadFinancialData on the equivalent CSV
+std::vector<FinancialData> loadFinancialDataBinary(const std::string& filename, std::vector<MacroData>& macro);
+std::vector<FinancialData> loadFinancialDataBinary(const std::string& filename, std::vector<MacroData>& macro, DataValidity& validity);
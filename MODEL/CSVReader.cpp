@@ -1,13 +1,65 @@
 #include "CSVReader.h"
+#include "FeatureSchema.h"
+#include "Calendar.h"
+#include "DataPreprocessing.h"
+#include "Profiler.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <limits>
+
+bool parseFinancialDataLine(const std::string& line, FinancialData& fd, MacroData& md, int& month) {
+    std::stringstream ss(line);
+    std::string token;
+
+    // missing (empty, "NA" or absent column) = NaN until extractValidity
+    auto readValue = [&](double& field) {
+        field = std::numeric_limits<double>::quiet_NaN();
+        if (std::getline(ss, token, ',')) {
+            if (!token.empty() && token != "NA") {
+                field = std::stod(token);
+            }
+        }
+        };
+
+
+    std::getline(ss, fd.date, ',');
+    if (!parseMonth(fd.date, month)) {
+        return false;
+    }
+
+
+    std::getline(ss, fd.symbol, ',');
+
+    size_t underscore_pos = fd.symbol.find('_');
+    if (underscore_pos != std::string::npos) {
+
+        fd.symbol = fd.symbol.substr(underscore_pos + 1);
+    }
+
+    // numeric columns in schema order
+    fd.nextMonthStockPrice = 0.0;
+    for (const FeatureField& field : featureSchema) {
+        if (field.csv_column == nullptr) continue;
+        readValue(field.row ? fd.*(field.row) : md.*(field.macro));
+    }
+    md.date = fd.date;
+    return true;
+}
+
+std::vector<FinancialData> loadFinancialData(const std::string& filename, std::vector<MacroData>& macro) {
+    DataValidity validity;
+    return loadFinancialData(filename, macro, validity);
+}
 
-std::vector<FinancialData> loadFinancialData(const std::string& filename) {
+std::vector<FinancialData> loadFinancialData(const std::string& filename, std::vector<MacroData>& macro, DataValidity& validity) {
+    PROFILE_SCOPE("loadFinancialData");
+    validity.fields.clear();
     std::vector<FinancialData> data;
+    macro.clear();
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Erreur lors de l'ouverture du fichier CSV." << std::endl;
@@ -21,69 +73,44 @@ std::vector<FinancialData> loadFinancialData(const std::string& filename) {
 
     std::map<std::string, std::vector<FinancialData>> dataBySymbol;
 
+    // macro row of each month, first one seen wins
+    MonthTable<MacroData> macroByMonth;
+    size_t invalidDates = 0;
+
     while (std::getline(file, line)) {
-        std::stringstream ss(line);
         FinancialData fd;
-        std::string token;
-
-        auto readValue = [&](double& field) {
-            if (std::getline(ss, token, ',')) {
-                if (token.empty() || token == "NA") {
-                    field = 0.0; 
-                }
-                else {
-                    field = std::stod(token);
-                }
-            }
-            };
-
-
-        std::getline(ss, fd.date, ',');
-
-
-        std::getline(ss, fd.symbol, ',');
-
-        size_t underscore_pos = fd.symbol.find('_');
-        if (underscore_pos != std::string::npos) {
-
-            fd.symbol = fd.symbol.substr(underscore_pos + 1);
+        MacroData md;
+        int month;
+        if (!parseFinancialDataLine(line, fd, md, month)) {
+            ++invalidDates;
+            continue;
         }
 
-        readValue(fd.stockPrice);
-        fd.nextMonthStockPrice = 0.0; 
-        readValue(fd.interestRate);
-        readValue(fd.unemploymentRate);
-        readValue(fd.inflation);
-        readValue(fd.growthRate);
-        readValue(fd.consumerSentiment);
-        readValue(fd.sectorSentiment);
-        readValue(fd.salesFigures);
-        readValue(fd.grossMargin);
-        readValue(fd.selfFinancingCapacity);
-        readValue(fd.netIncome);
-        readValue(fd.profitPerStock);
-        readValue(fd.freeCashFlow);
-        readValue(fd.netDebtToEquity);
-        readValue(fd.roa);
-        readValue(fd.ebitda);
-        readValue(fd.pricingDCF);
-        readValue(fd.sharpeRatio);
-        readValue(fd.cagr);
-        readValue(fd.var);
-        readValue(fd.cvar);
-        readValue(fd.beta);
-        readValue(fd.dividendYield);
-
+        if (!macroByMonth.contains(month)) {
+            macroByMonth.add(month) = md;
+        }
+        fd.period = month;  // month index until the periods are known
         dataBySymbol[fd.symbol].push_back(fd);
     }
 
     file.close();
 
+    if (invalidDates) {
+        std::cerr << "Skipped " << invalidDates << " rows with an invalid date (expected YYYYMM)." << std::endl;
+    }
+
+    // periods number the months that have data, in date order
+    const Calendar& calendar = macroByMonth.calendar();
+    const std::vector<int> periodOfMonth = macroByMonth.ranks();
+    for (int p = 0; p < calendar.num_months; ++p) {
+        if (macroByMonth.has(p)) macro.push_back(std::move(macroByMonth.at(p)));
+    }
+
     for (auto& pair : dataBySymbol) {
         const std::string& symbol = pair.first;
         std::vector<FinancialData>& records = pair.second;
         std::sort(records.begin(), records.end(), [](const FinancialData& a, const FinancialData& b) {
-            return a.date < b.date;
+            return a.period < b.period;
             });
 
 
@@ -95,9 +122,12 @@ std::vector<FinancialData> loadFinancialData(const std::string& filename) {
 
                 records[i].nextMonthStockPrice = records[i].stockPrice; 
             }
+            records[i].period = periodOfMonth[calendar.period(records[i].period)];
             data.push_back(records[i]);
         }
     }
 
+    extractValidity(data, macro, validity);
+    PROFILE_COUNT("csv.rows", data.size());
     return data;
 }
@@ -2,5 +2,14 @@
 #include <vector>
 #include <string>
 #include "FinancialData.h"
+#include "FeatureSchema.h"
 
-std::vector<FinancialData> loadFinancialData(const std::string& filename);
+// one financial_data.csv line, missing values as NaN; false if the date does not parse.
+// month = month index of the date (Calendar.h), fd.period is left unset
+bool parseFinancialDataLine(const std::string& line, FinancialData& fd, MacroData& md, int& month);
+
+// macro columns go to one MacroData per date (sorted by date), rows point at it through period
+std::vector<FinancialData> loadFinancialData(const std::string& filename, std::vector<MacroData>& macro);
+
+// same, missing values ("", "NA") read as 0.0 with their bit cleared in validity
+std::vector<FinancialData> loadFinancialData(const std::string& filename, std::vector<MacroData>& macro, DataValidity& validity);
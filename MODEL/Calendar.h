@@ -0,0 +1,188 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "ValidityMask.h"
+
+// Dates as integers: months count from year 0 (year * 12 + month - 1), days from 1970-01-01.
+// Anything keyed by date (series, joins, sorting) works on these instead of "YYYYMM" strings.
+
+inline int monthIndex(int year, int month) { return year * 12 + month - 1; }
+inline int monthYear(int month_index) { return month_index / 12; }
+inline int monthOfYear(int month_index) { return month_index % 12 + 1; }  // 1..12
+
+// days_from_civil (proleptic Gregorian)
+inline int dayIndex(int year, int month, int day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+namespace calendar_detail {
+inline bool digits(const std::string& s, size_t pos, size_t count, int& out) {
+    if (pos + count > s.size()) return false;
+    out = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        out = out * 10 + (s[i] - '0');
+    }
+    return true;
+}
+}
+
+// "YYYYMM", "YYYY-MM" or "YYYY-MM-DD" (day ignored)
+inline bool parseMonth(const std::string& date, int& month_index) {
+    int year, month;
+    if (!calendar_detail::digits(date, 0, 4, year)) return false;
+    size_t pos = date.size() > 4 && date[4] == '-' ? 5 : 4;
+    if (!calendar_detail::digits(date, pos, 2, month) || month < 1 || month > 12) return false;
+    month_index = monthIndex(year, month);
+    return true;
+}
+
+// "YYYY-MM-DD"
+inline bool parseDay(const std::string& date, int& day_index) {
+    int year, month, day;
+    if (!calendar_detail::digits(date, 0, 4, year) || date.size() < 10 || date[4] != '-' || date[7] != '-'
+        || !calendar_detail::digits(date, 5, 2, month) || !calendar_detail::digits(date, 8, 2, day)) return false;
+    day_index = dayIndex(year, month, day);
+    return true;
+}
+
+// "YYYYMM", the financial_data.csv date format
+inline std::string formatMonth(int month_index) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d%02d", monthYear(month_index), monthOfYear(month_index));
+    return buffer;
+}
+
+// Contiguous range of months, period 0 = first_month
+struct Calendar {
+    int first_month = 0;
+    int num_months = 0;
+
+    Calendar() = default;
+    Calendar(int first_month, int last_month)  // both included
+        : first_month(first_month), num_months(last_month >= first_month ? last_month - first_month + 1 : 0) {}
+
+    int last_month() const { return first_month + num_months - 1; }
+    bool contains(int month_index) const { return month_index >= first_month && month_index < first_month + num_months; }
+    int period(int month_index) const { return contains(month_index) ? month_index - first_month : -1; }
+    int period(const std::string& date) const {
+        int month_index;
+        return parseMonth(date, month_index) ? period(month_index) : -1;
+    }
+    int month(int period) const { return first_month + period; }
+    std::string date(int period) const { return formatMonth(month(period)); }
+
+    // same last month, 'months' more at the front (year-over-year changes, quarter starts)
+    Calendar extended_back(int months) const { return Calendar(first_month - months, last_month()); }
+};
+
+// A value per month of a calendar, flat and indexed by period; months never set read as missing
+class MonthlySeries {
+public:
+    MonthlySeries() = default;
+    explicit MonthlySeries(const Calendar& calendar)
+        : calendar_(calendar), values(calendar.num_months, 0.0), valid(calendar.num_months) {}
+
+    const Calendar& calendar() const { return calendar_; }
+
+    // by month index, out-of-calendar months are ignored / missing
+    void set_month(int month_index, double value) {
+        int p = calendar_.period(month_index);
+        if (p >= 0) set(p, value);
+    }
+    bool has_month(int month_index) const {
+        int p = calendar_.period(month_index);
+        return p >= 0 && valid.test(p);
+    }
+    double at_month(int month_index) const { return values[calendar_.period(month_index)]; }
+
+    // by period
+    void set(int period, double value) { values[period] = value; valid.set(period); }
+    bool has(int period) const { return valid.test(period); }
+    double get(int period, double fallback) const { return valid.test(period) ? values[period] : fallback; }
+
+    bool empty() const { return valid.count() == 0; }
+    int last_valid() const {  // -1 if none
+        for (int p = calendar_.num_months - 1; p >= 0; --p) {
+            if (valid.test(p)) return p;
+        }
+        return -1;
+    }
+
+    const std::vector<double>& data() const { return values; }
+    const ValidityMask& mask() const { return valid; }
+
+private:
+    Calendar calendar_;
+    std::vector<double> values;
+    ValidityMask valid;
+};
+
+// Values keyed by month, over a calendar that grows to cover every month added (geometric
+// growth: files in date order grow it one month at a time)
+template <typename T>
+class MonthTable {
+public:
+    const Calendar& calendar() const { return calendar_; }
+    bool contains(int month_index) const {
+        int p = calendar_.period(month_index);
+        return p >= 0 && present.test(p);
+    }
+    bool has(int period) const { return present.test(period); }
+    T& at(int period) { return values[period]; }
+    const T& at(int period) const { return values[period]; }
+
+    // the month's slot, default-constructed on first use
+    T& add(int month_index) {
+        grow(month_index);
+        int p = calendar_.period(month_index);
+        present.set(p);
+        return values[p];
+    }
+
+    // dense periods of the months present, in date order (-1 = absent), indexed by calendar period
+    std::vector<int> ranks() const {
+        std::vector<int> rank(calendar_.num_months, -1);
+        int next = 0;
+        for (int p = 0; p < calendar_.num_months; ++p) {
+            if (present.test(p)) rank[p] = next++;
+        }
+        return rank;
+    }
+
+private:
+    void grow(int month_index) {
+        if (calendar_.contains(month_index)) return;
+        int first = month_index, last = month_index;
+        if (calendar_.num_months) {
+            first = std::min(month_index, calendar_.first_month);
+            last = std::max(month_index, calendar_.last_month());
+            if (month_index < calendar_.first_month) first = std::min(first, calendar_.first_month - calendar_.num_months);
+            if (month_index > calendar_.last_month()) last = std::max(last, calendar_.last_month() + calendar_.num_months);
+        }
+        Calendar grown(first, last);
+        std::vector<T> table(grown.num_months);
+        ValidityMask grown_present(grown.num_months);
+        for (int p = 0; p < calendar_.num_months; ++p) {
+            if (!present.test(p)) continue;
+            int q = grown.period(calendar_.month(p));
+            table[q] = std::move(values[p]);
+            grown_present.set(q);
+        }
+        calendar_ = grown;
+        values.swap(table);
+        present = std::move(grown_present);
+    }
+
+    Calendar calendar_;
+    std::vector<T> values;
+    ValidityMask present;
+};
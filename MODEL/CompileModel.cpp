@@ -0,0 +1,154 @@
+// ahead-of-time model compiler: compile_model --model=model.bin --out=scorer.h [--name=portfolio_scorer]
+// (model.bin from portfolio --save-model=...). --reference=M,A,K,U [--seed=N] --save=ref.bin
+// builds a random model with M/A/K units and U unfolds instead, saves it and compiles it;
+// the build uses it to check generated scorers against the engine.
+#include "ModelCompiler.h"
+#include "ModelFile.h"
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+bool isIdentifier(const std::string& name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) return false;
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+    }
+    return true;
+}
+
+void usage() {
+    std::cerr << "usage: compile_model (--model=path | --reference=M,A,K,U [--seed=N] [--save=path])"
+        << " --out=path [--name=identifier]" << std::endl;
+}
+
+// whole of text as a base-10 integer in [min, max]
+bool parseInteger(const std::string& text, long min, long max, long& value) {
+    if (text.empty() || std::isspace(static_cast<unsigned char>(text[0]))) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtol(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0' && value >= min && value <= max;
+}
+
+// M,A,K,U: unit counts of the three cells (at least 1) and the unfolds (at least 0)
+bool parseShape(const std::string& shape, int units[4]) {
+    std::istringstream ss(shape);
+    std::string field;
+    for (int i = 0; i < 4; ++i) {
+        long value = 0;
+        if (!std::getline(ss, field, ',') || !parseInteger(field, i < 3 ? 1 : 0, INT_MAX, value)) return false;
+        units[i] = static_cast<int>(value);
+    }
+    return !std::getline(ss, field, ',');
+}
+
+// every parameter the scorer reads drawn at random, states and leaks included
+PortfolioModel referenceModel(const int units[4], unsigned seed) {
+
+    PortfolioModel model(units[0], units[1], units[2]);
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> weight(-1.0, 1.0), positive(0.1, 2.0);
+    for (LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+        cell->ode_solver_unfolds = units[3];
+        for (auto& row : cell->W) {
+            for (double& w : row) w = weight(rng);
+        }
+        for (int i = 0; i < cell->num_units; ++i) {
+            cell->cm_t[i] = positive(rng);
+            cell->gleak[i] = positive(rng);
+            cell->vleak[i] = weight(rng);
+        }
+    }
+    for (std::vector<double>* state : { &model.state_macro, &model.state_accounting, &model.state_market }) {
+        for (double& v : *state) v = weight(rng);
+    }
+    for (auto& row : model.final_layer.weights) {
+        for (double& w : row) w = weight(rng);
+    }
+    for (double& b : model.final_layer.biases) b = weight(rng);
+    model.repack();
+    return model;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string model_path, out_path, reference, save_path;
+    std::string name = "portfolio_scorer";
+    unsigned seed = 42;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const char* key) {
+            size_t n = std::string(key).size();
+            return arg.rfind(key, 0) == 0 ? arg.substr(n) : std::string();
+        };
+        if (!value("--model=").empty()) model_path = value("--model=");
+        else if (!value("--out=").empty()) out_path = value("--out=");
+        else if (!value("--name=").empty()) name = value("--name=");
+        else if (!value("--reference=").empty()) reference = value("--reference=");
+        else if (!value("--seed=").empty()) {
+            long number = 0;
+            if (!parseInteger(value("--seed="), 0, 4294967295L, number)) {
+                std::cerr << "Bad --seed: " << value("--seed=") << std::endl;
+                usage();
+                return 1;
+            }
+            seed = static_cast<unsigned>(number);
+        }
+        else if (!value("--save=").empty()) save_path = value("--save=");
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            usage();
+            return 1;
+        }
+    }
+    if (out_path.empty() || model_path.empty() == reference.empty()) {
+        std::cerr << "compile_model needs --out and one of --model / --reference" << std::endl;
+        return 1;
+    }
+    if (!isIdentifier(name)) {
+        std::cerr << "Not a C++ identifier: " << name << std::endl;
+        return 1;
+    }
+
+    int units[4] = { 0, 0, 0, 0 };
+    if (!reference.empty() && !parseShape(reference, units)) {
+        std::cerr << "Bad --reference: " << reference << " (unit counts at least 1, unfolds at least 0)" << std::endl;
+        usage();
+        return 1;
+    }
+
+    PortfolioModel model(1, 1, 1);
+    if (!reference.empty()) {
+        model = referenceModel(units, seed);
+        if (!save_path.empty() && !saveModel(save_path, model)) {
+            return 1;
+        }
+    }
+    else if (!loadModel(model_path, model)) {
+        return 1;
+    }
+    if (model.ltc_macro.solver == ODESolver::Adaptive) {
+        std::cerr << "Trained with --ode=adaptive, the scorer runs fixed unfolds only: " << model_path << std::endl;
+        return 1;
+    }
+
+    std::ofstream file(out_path, std::ios::trunc);
+    file << compileModel(model, name);
+    if (!file) {
+        std::cerr << "Cannot write: " << out_path << std::endl;
+        return 1;
+    }
+    std::cout << "Compiled " << model.ltc_macro.num_units << "/" << model.ltc_accounting.num_units << "/"
+        << model.ltc_market.num_units << " units, " << model.ltc_macro.ode_solver_unfolds << " unfolds -> "
+        << out_path << " (namespace " << name << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,265 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include "PortfolioModel.h"
+#include "AdamOptimizer.h"
+#include "Backtest.h"
+
+// rows of data sharing one date, in panel order
+struct MonthBatch {
+    size_t period;
+    std::vector<size_t> rows;
+};
+
+inline std::vector<MonthBatch> groupByMonth(const std::vector<FinancialData>& data, const PricePanel& panel) {
+    std::vector<MonthBatch> months(panel.num_periods());
+    for (size_t t = 0; t < months.size(); ++t) {
+        months[t].period = t;
+    }
+    for (size_t r = 0; r < data.size(); ++r) {
+        months[data[r].period].rows.push_back(r);
+    }
+    return months;
+}
+
+// Whole-universe model: every symbol of a month goes through the shared LTC trio as one
+// [symbols x features] block, a single attention head mixes information across assets and
+// the scores are softmaxed over the universe into portfolio weights.
+// Asset embedding = LTC trio output | normalized feature row (the LTC cells do not read
+// their sensory inputs yet, so the raw features carry the per-asset signal).
+class CrossAssetModel {
+public:
+    static constexpr int num_features = PortfolioModel::input_size_macro
+        + PortfolioModel::input_size_accounting + PortfolioModel::input_size_market;
+
+    LTCCell ltc_macro;
+    LTCCell ltc_accounting;
+    LTCCell ltc_market;
+
+    int ltc_size;
+    int embed_size;  // D
+    int key_size;    // d
+
+    std::vector<std::vector<double>> Wq, Wk, Wv;  // [D x d]
+    std::vector<std::vector<double>> score_w;     // [1 x (D + d)]
+    std::vector<double> score_b;                   // [1]
+
+    // forward results for the last month
+    size_t n = 0;
+    std::vector<double> X, Q, K, V, A, M, scores, weights;
+
+    CrossAssetModel(int num_units_macro, int num_units_accounting, int num_units_market, int key_size, double lr)
+        : ltc_macro(num_units_macro, PortfolioModel::input_size_macro),
+        ltc_accounting(num_units_accounting, PortfolioModel::input_size_accounting),
+        ltc_market(num_units_market, PortfolioModel::input_size_market),
+        ltc_size(num_units_macro + num_units_accounting + num_units_market),
+        embed_size(ltc_size + num_features), key_size(key_size),
+        adam_q(lr, 0.9, 0.999, 1e-8), adam_k(lr, 0.9, 0.999, 1e-8), adam_v(lr, 0.9, 0.999, 1e-8), adam_score(lr, 0.9, 0.999, 1e-8) {
+        double scale = 1.0 / std::sqrt(static_cast<double>(embed_size));
+        Wq = random_matrix(embed_size, key_size, scale);
+        Wk = random_matrix(embed_size, key_size, scale);
+        Wv = random_matrix(embed_size, key_size, scale);
+        score_w = random_matrix(1, embed_size + key_size, scale);
+        score_b = std::vector<double>(1, 0.0);
+        adam_q.initialize(Wq, no_bias);
+        adam_k.initialize(Wk, no_bias);
+        adam_v.initialize(Wv, no_bias);
+        adam_score.initialize(score_w, score_b);
+    }
+
+    // ODESolver::Adaptive work of the three cells since the last call
+    ODEStats take_ode_stats() {
+        ODEStats stats;
+        for (LTCCell* cell : { &ltc_macro, &ltc_accounting, &ltc_market }) {
+            stats.add(cell->ode_stats);
+            cell->ode_stats = ODEStats();
+        }
+        return stats;
+    }
+
+    // portfolio weights over data[rows], left in weights
+    void forward(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro, const std::vector<size_t>& rows) {
+        n = rows.size();
+        const int D = embed_size;
+        const int d = key_size;
+
+        // shared-weight LTC trio, one batched call per cell; macro is the same for the
+        // whole month so it runs once and is broadcast
+        std::vector<double> states_macro(ltc_macro.num_units, 0.0);
+        std::vector<double> states_accounting(n * ltc_accounting.num_units, 0.0);
+        std::vector<double> states_market(n * ltc_market.num_units, 0.0);
+        ltc_macro.ode_step_batch(states_macro, 1);
+        ltc_accounting.ode_step_batch(states_accounting, n);
+        ltc_market.ode_step_batch(states_market, n);
+
+        gatherInputs(data, macro, rows.data(), n, tiles);
+
+        X.assign(n * D, 0.0);
+        const int macro_width = PortfolioModel::input_size_macro;
+        const int accounting_width = PortfolioModel::input_size_accounting;
+        const int market_width = PortfolioModel::input_size_market;
+        for (size_t i = 0; i < n; ++i) {
+            double* x = &X[i * D];
+            x = std::copy(states_macro.begin(), states_macro.end(), x);
+            x = std::copy_n(&states_accounting[i * ltc_accounting.num_units], ltc_accounting.num_units, x);
+            x = std::copy_n(&states_market[i * ltc_market.num_units], ltc_market.num_units, x);
+            x = std::copy_n(&tiles.macro[i * macro_width], macro_width, x);
+            x = std::copy_n(&tiles.accounting[i * accounting_width], accounting_width, x);
+            std::copy_n(&tiles.market[i * market_width], market_width, x);
+        }
+
+        project(X, Wq, Q);
+        project(X, Wk, K);
+        project(X, Wv, V);
+
+        // A = rowsoftmax(Q K^T / sqrt(d)), M = A V
+        double inv_sqrt_d = 1.0 / std::sqrt(static_cast<double>(d));
+        A.assign(n * n, 0.0);
+        M.assign(n * d, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            double* a = &A[i * n];
+            const double* q = &Q[i * d];
+            double max_s = -1e300;
+            for (size_t j = 0; j < n; ++j) {
+                const double* k = &K[j * d];
+                double s = 0.0;
+                for (int c = 0; c < d; ++c) s += q[c] * k[c];
+                a[j] = s * inv_sqrt_d;
+                max_s = std::max(max_s, a[j]);
+            }
+            double sum = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                a[j] = std::exp(a[j] - max_s);
+                sum += a[j];
+            }
+            double* m = &M[i * d];
+            for (size_t j = 0; j < n; ++j) {
+                a[j] /= sum;
+                const double* v = &V[j * d];
+                for (int c = 0; c < d; ++c) m[c] += a[j] * v[c];
+            }
+        }
+
+        // scores over [X | M], softmax over the universe
+        scores.assign(n, score_b[0]);
+        const std::vector<double>& w = score_w[0];
+        for (size_t i = 0; i < n; ++i) {
+            const double* x = &X[i * D];
+            const double* m = &M[i * d];
+            double s = 0.0;
+            for (int c = 0; c < D; ++c) s += w[c] * x[c];
+            for (int c = 0; c < d; ++c) s += w[D + c] * m[c];
+            scores[i] += s;
+        }
+        weights = softmax(scores);
+    }
+
+    // gradient ascent on the portfolio return sum(w * r) of the last forward, returns it
+    double update(const std::vector<double>& asset_returns, int t) {
+        const int D = embed_size;
+        const int d = key_size;
+        double R = 0.0;
+        for (size_t i = 0; i < n; ++i) R += weights[i] * asset_returns[i];
+
+        // loss = -R, dloss/dscore_i = -w_i (r_i - R)
+        std::vector<double> g(n);
+        for (size_t i = 0; i < n; ++i) g[i] = -weights[i] * (asset_returns[i] - R);
+
+        std::vector<std::vector<double>> dscore_w(1, std::vector<double>(D + d, 0.0));
+        std::vector<double> dscore_b(1, 0.0);
+        std::vector<double> dM(n * d);
+        for (size_t i = 0; i < n; ++i) {
+            const double* x = &X[i * D];
+            const double* m = &M[i * d];
+            for (int c = 0; c < D; ++c) dscore_w[0][c] += g[i] * x[c];
+            for (int c = 0; c < d; ++c) {
+                dscore_w[0][D + c] += g[i] * m[c];
+                dM[i * d + c] = g[i] * score_w[0][D + c];
+            }
+            dscore_b[0] += g[i];
+        }
+
+        // through the attention, one row of dA / dS at a time
+        std::vector<double> dQ(n * d, 0.0), dK(n * d, 0.0), dV(n * d, 0.0), ds(n);
+        double inv_sqrt_d = 1.0 / std::sqrt(static_cast<double>(d));
+        for (size_t i = 0; i < n; ++i) {
+            const double* a = &A[i * n];
+            const double* dm = &dM[i * d];
+            double row_dot = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                const double* v = &V[j * d];
+                double da = 0.0;
+                for (int c = 0; c < d; ++c) {
+                    da += dm[c] * v[c];
+                    dV[j * d + c] += a[j] * dm[c];
+                }
+                ds[j] = da;
+                row_dot += a[j] * da;
+            }
+            const double* q = &Q[i * d];
+            double* dq = &dQ[i * d];
+            for (size_t j = 0; j < n; ++j) {
+                double s = a[j] * (ds[j] - row_dot) * inv_sqrt_d;
+                const double* k = &K[j * d];
+                double* dk = &dK[j * d];
+                for (int c = 0; c < d; ++c) {
+                    dq[c] += s * k[c];
+                    dk[c] += s * q[c];
+                }
+            }
+        }
+
+        std::vector<std::vector<double>> dWq, dWk, dWv;
+        project_grad(dQ, dWq);
+        project_grad(dK, dWk);
+        project_grad(dV, dWv);
+
+        adam_q.update(Wq, no_bias, dWq, no_bias, t);
+        adam_k.update(Wk, no_bias, dWk, no_bias, t);
+        adam_v.update(Wv, no_bias, dWv, no_bias, t);
+        adam_score.update(score_w, score_b, dscore_w, dscore_b, t);
+        return R;
+    }
+
+private:
+    InputTiles tiles;
+    AdamOptimizer adam_q, adam_k, adam_v, adam_score;
+    std::vector<double> no_bias;
+
+    // out[n x d] = X[n x D] W[D x d]
+    void project(const std::vector<double>& in, const std::vector<std::vector<double>>& W, std::vector<double>& out) const {
+        out.assign(n * key_size, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            const double* x = &in[i * embed_size];
+            double* o = &out[i * key_size];
+            for (int r = 0; r < embed_size; ++r) {
+                const std::vector<double>& w = W[r];
+                for (int c = 0; c < key_size; ++c) o[c] += x[r] * w[c];
+            }
+        }
+    }
+
+    // dW[D x d] = X^T grad[n x d]
+    void project_grad(const std::vector<double>& grad, std::vector<std::vector<double>>& dW) const {
+        dW.assign(embed_size, std::vector<double>(key_size, 0.0));
+        for (size_t i = 0; i < n; ++i) {
+            const double* x = &X[i * embed_size];
+            const double* g = &grad[i * key_size];
+            for (int r = 0; r < embed_size; ++r) {
+                for (int c = 0; c < key_size; ++c) dW[r][c] += x[r] * g[c];
+            }
+        }
+    }
+
+    static std::vector<std::vector<double>> random_matrix(int rows, int cols, double scale) {
+        std::mt19937 gen(std::random_device{}());
+        std::uniform_real_distribution<> dis(-scale, scale);
+        std::vector<std::vector<double>> mat(rows, std::vector<double>(cols));
+        for (auto& row : mat) {
+            for (auto& v : row) v = dis(gen);
+        }
+        return mat;
+    }
+};
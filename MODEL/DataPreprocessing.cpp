@@ -1,41 +1,18 @@
 #include "DataPreprocessing.h"
+#include "FeatureSchema.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
 #include <algorithm>
 #include <cmath>
 #include <functional>
 
-void normalizeData(std::vector<FinancialData>& data) {
-
-    typedef double FinancialData::* MemberPtr;
-    std::vector<std::pair<std::string, MemberPtr>> attributes = {
-        {"stockPrice", &FinancialData::stockPrice},
-        {"nextMonthStockPrice", &FinancialData::nextMonthStockPrice},
-        {"interestRate", &FinancialData::interestRate},
-        {"unemploymentRate", &FinancialData::unemploymentRate},
-        {"inflation", &FinancialData::inflation},
-        {"growthRate", &FinancialData::growthRate},
-        {"consumerSentiment", &FinancialData::consumerSentiment},
-        {"sectorSentiment", &FinancialData::sectorSentiment},
-        {"salesFigures", &FinancialData::salesFigures},
-        {"grossMargin", &FinancialData::grossMargin},
-        {"selfFinancingCapacity", &FinancialData::selfFinancingCapacity},
-        {"netIncome", &FinancialData::netIncome},
-        {"profitPerStock", &FinancialData::profitPerStock},
-        {"freeCashFlow", &FinancialData::freeCashFlow},
-        {"netDebtToEquity", &FinancialData::netDebtToEquity},
-        {"roa", &FinancialData::roa},
-        {"ebitda", &FinancialData::ebitda},
-        {"pricingDCF", &FinancialData::pricingDCF},
-        {"sharpeRatio", &FinancialData::sharpeRatio},
-        {"cagr", &FinancialData::cagr},
-        {"var", &FinancialData::var},
-        {"cvar", &FinancialData::cvar},
-        {"beta", &FinancialData::beta},
-        {"dividendYield", &FinancialData::dividendYield}
-    };
+// z-score each attribute over all records
+template <typename Record>
+static void normalizeAttributes(std::vector<Record>& data,
+    const std::vector<std::pair<std::string, double Record::*>>& attributes) {
 
     for (size_t i = 0; i < attributes.size(); ++i) {
-        std::string& name = attributes[i].first;
-        MemberPtr memberPtr = attributes[i].second;
+        double Record::* memberPtr = attributes[i].second;
 
         // avg
         double sum = 0.0;
@@ -62,3 +39,410 @@ void normalizeData(std::vector<FinancialData>& data) {
         }
     }
 }
+
+void normalizeData(std::vector<FinancialData>& data, std::vector<MacroData>& macro) {
+    PROFILE_SCOPE("normalizeData");
+
+    typedef double FinancialData::* MemberPtr;
+    typedef double MacroData::* MacroPtr;
+    std::vector<std::pair<std::string, MemberPtr>> attributes;
+    std::vector<std::pair<std::string, MacroPtr>> macroAttributes;
+    for (const FeatureField& field : featureSchema) {
+        if (field.row)
+            attributes.emplace_back(field.name, field.row);
+        else
+            macroAttributes.emplace_back(field.name, field.macro);
+    }
+
+    normalizeAttributes(data, attributes);
+    // one value per month: statistics over dates
+    normalizeAttributes(macro, macroAttributes);
+}
+
+// featureSchema indices of the row / macro attributes, in schema order
+static std::vector<size_t> schemaFields(bool row) {
+    std::vector<size_t> fields;
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        if ((featureSchema[f].row != nullptr) == row) fields.push_back(f);
+    }
+    return fields;
+}
+
+// mask of each field, nullptr = all observed (no validity)
+static std::vector<const ValidityMask*> fieldMasks(const std::vector<size_t>& fields, const DataValidity& validity) {
+    std::vector<const ValidityMask*> masks(fields.size(), nullptr);
+    if (validity.fields.empty()) return masks;
+    for (size_t a = 0; a < fields.size(); ++a) {
+        masks[a] = &validity.fields[fields[a]];
+    }
+    return masks;
+}
+
+static double observedWeight(const ValidityMask* mask, size_t i) {
+    return mask ? static_cast<double>(mask->test(i)) : 1.0;
+}
+
+NormalizationMoments::NormalizationMoments(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+    const DataValidity& validity) {
+    PROFILE_SCOPE("NormalizationMoments");
+    const std::vector<size_t> row_fields = schemaFields(true), macro_fields = schemaFields(false);
+    const std::vector<const ValidityMask*> row_masks = fieldMasks(row_fields, validity);
+    const std::vector<const ValidityMask*> macro_masks = fieldMasks(macro_fields, validity);
+    const size_t A = row_fields.size(), M = macro_fields.size(), P = macro.size();
+    num_periods = P;
+    num_rows_attributes = A;
+    num_macro_attributes = M;
+
+    // shifts: means of the observed values
+    row_shift.assign(A, 0.0);
+    std::vector<double> observed(A, 0.0);
+    for (size_t r = 0; r < data.size(); ++r) {
+        for (size_t a = 0; a < A; ++a) {
+            double w = observedWeight(row_masks[a], r);
+            row_shift[a] += w * (data[r].*(featureSchema[row_fields[a]].row));
+            observed[a] += w;
+        }
+    }
+    for (size_t a = 0; a < A; ++a) row_shift[a] = observed[a] > 0.0 ? row_shift[a] / observed[a] : 0.0;
+    macro_shift.assign(M, 0.0);
+    observed.assign(M, 0.0);
+    for (size_t t = 0; t < P; ++t) {
+        for (size_t a = 0; a < M; ++a) {
+            double w = observedWeight(macro_masks[a], t);
+            macro_shift[a] += w * (macro[t].*(featureSchema[macro_fields[a]].macro));
+            observed[a] += w;
+        }
+    }
+    for (size_t a = 0; a < M; ++a) macro_shift[a] = observed[a] > 0.0 ? macro_shift[a] / observed[a] : 0.0;
+
+    // per-period sums of the observed values in slot period + 1, then prefix over periods
+    row_count.assign((P + 1) * A, 0.0);
+    row_sum.assign((P + 1) * A, 0.0);
+    row_sum_sq.assign((P + 1) * A, 0.0);
+    for (size_t r = 0; r < data.size(); ++r) {
+        size_t slot = data[r].period + 1;
+        double* count = &row_count[slot * A];
+        double* sum = &row_sum[slot * A];
+        double* sum_sq = &row_sum_sq[slot * A];
+        for (size_t a = 0; a < A; ++a) {
+            double w = observedWeight(row_masks[a], r);
+            double d = w * (data[r].*(featureSchema[row_fields[a]].row) - row_shift[a]);
+            count[a] += w;
+            sum[a] += d;
+            sum_sq[a] += d * d;
+        }
+    }
+    macro_count.assign((P + 1) * M, 0.0);
+    macro_sum.assign((P + 1) * M, 0.0);
+    macro_sum_sq.assign((P + 1) * M, 0.0);
+    for (size_t t = 0; t < P; ++t) {
+        for (size_t a = 0; a < M; ++a) {
+            double w = observedWeight(macro_masks[a], t);
+            double d = w * (macro[t].*(featureSchema[macro_fields[a]].macro) - macro_shift[a]);
+            macro_count[(t + 1) * M + a] = w;
+            macro_sum[(t + 1) * M + a] = d;
+            macro_sum_sq[(t + 1) * M + a] = d * d;
+        }
+    }
+    for (size_t t = 1; t <= P; ++t) {
+        for (size_t a = 0; a < A; ++a) {
+            row_count[t * A + a] += row_count[(t - 1) * A + a];
+            row_sum[t * A + a] += row_sum[(t - 1) * A + a];
+            row_sum_sq[t * A + a] += row_sum_sq[(t - 1) * A + a];
+        }
+        for (size_t a = 0; a < M; ++a) {
+            macro_count[t * M + a] += macro_count[(t - 1) * M + a];
+            macro_sum[t * M + a] += macro_sum[(t - 1) * M + a];
+            macro_sum_sq[t * M + a] += macro_sum_sq[(t - 1) * M + a];
+        }
+    }
+}
+
+NormalizationStats NormalizationMoments::stats(int first_period, int last_period) const {
+    const size_t P = num_periods;
+    const size_t first = std::min<size_t>(std::max(first_period, 0), P);
+    const size_t last = std::min<size_t>(std::max<size_t>(last_period, first), P);
+
+    auto range = [&](const std::vector<double>& count, const std::vector<double>& sum, const std::vector<double>& sum_sq,
+        const std::vector<double>& shift, size_t A, std::vector<AttributeStats>& out) {
+        out.resize(A);
+        for (size_t a = 0; a < A; ++a) {
+            double n = count[last * A + a] - count[first * A + a];
+            if (n == 0.0) {
+                out[a] = { shift[a], 0.0 };
+                continue;
+            }
+            double mean = (sum[last * A + a] - sum[first * A + a]) / n;
+            double variance = (sum_sq[last * A + a] - sum_sq[first * A + a]) / n - mean * mean;
+            out[a] = { shift[a] + mean, std::sqrt(std::max(0.0, variance)) };
+        }
+    };
+
+    NormalizationStats stats;
+    range(row_count, row_sum, row_sum_sq, row_shift, num_rows_attributes, stats.rows);
+    range(macro_count, macro_sum, macro_sum_sq, macro_shift, num_macro_attributes, stats.macro);
+    return stats;
+}
+
+void applyNormalization(std::vector<FinancialData>& data, std::vector<MacroData>& macro, const NormalizationStats& stats,
+    const DataValidity& validity) {
+    PROFILE_SCOPE("applyNormalization");
+    const std::vector<size_t> row_fields = schemaFields(true), macro_fields = schemaFields(false);
+    const std::vector<const ValidityMask*> row_masks = fieldMasks(row_fields, validity);
+    const std::vector<const ValidityMask*> macro_masks = fieldMasks(macro_fields, validity);
+    for (size_t a = 0; a < row_fields.size(); ++a) {
+        double FinancialData::* member = featureSchema[row_fields[a]].row;
+        const AttributeStats& s = stats.rows[a];
+        double scale = s.stddev != 0 ? 1.0 / s.stddev : 0.0;
+        for (size_t r = 0; r < data.size(); ++r) {
+            double& val = data[r].*member;
+            val = (val - s.mean) * scale * observedWeight(row_masks[a], r);
+        }
+    }
+    for (size_t a = 0; a < macro_fields.size(); ++a) {
+        double MacroData::* member = featureSchema[macro_fields[a]].macro;
+        const AttributeStats& s = stats.macro[a];
+        double scale = s.stddev != 0 ? 1.0 / s.stddev : 0.0;
+        for (size_t t = 0; t < macro.size(); ++t) {
+            double& val = macro[t].*member;
+            val = (val - s.mean) * scale * observedWeight(macro_masks[a], t);
+        }
+    }
+}
+
+DataValidity selectRows(const DataValidity& validity, const std::vector<size_t>& rows) {
+    DataValidity selected;
+    if (validity.fields.empty()) return selected;
+    selected.fields.resize(featureSchemaSize);
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        if (!featureSchema[f].row) {
+            selected.fields[f] = validity.fields[f];
+            continue;
+        }
+        ValidityMask mask(rows.size());
+        for (size_t k = 0; k < rows.size(); ++k) {
+            if (validity.fields[f].test(rows[k])) mask.set(k);
+        }
+        selected.fields[f] = mask;
+    }
+    return selected;
+}
+
+// Record fields are strided; the column kernels below run on contiguous buffers instead
+template <typename Record>
+static void gatherColumn(const std::vector<Record>& records, double Record::* member, std::vector<double>& column) {
+    column.resize(records.size());
+    for (size_t i = 0; i < records.size(); ++i) column[i] = records[i].*member;
+}
+
+template <typename Record>
+static void scatterColumn(std::vector<Record>& records, double Record::* member, const std::vector<double>& column) {
+    for (size_t i = 0; i < records.size(); ++i) records[i].*member = column[i];
+}
+
+// observed = 1.0 / 0.0, NaN -> 0.0
+static void splitMissing(std::vector<double>& column, std::vector<double>& observed) {
+    observed.resize(column.size());
+    for (size_t i = 0; i < column.size(); ++i) {
+        double x = column[i];
+        double m = static_cast<double>(x == x);
+        observed[i] = m;
+        column[i] = m != 0.0 ? x : 0.0;
+    }
+}
+
+static double sumOf(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    return sum;
+}
+
+static double medianOf(std::vector<double>& values) {
+    size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    double upper = values[mid];
+    if (values.size() % 2) return upper;
+    return 0.5 * (upper + *std::max_element(values.begin(), values.begin() + mid));
+}
+
+static bool isPriceField(const FeatureField& field) {
+    return field.row == &FinancialData::stockPrice || field.row == &FinancialData::nextMonthStockPrice;
+}
+
+void extractValidity(std::vector<FinancialData>& data, std::vector<MacroData>& macro, DataValidity& validity) {
+    PROFILE_SCOPE("extractValidity");
+    validity.fields.assign(featureSchemaSize, ValidityMask());
+    std::vector<double> column, observed;
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        const FeatureField& field = featureSchema[f];
+        if (field.row) {
+            gatherColumn(data, field.row, column);
+            splitMissing(column, observed);
+            scatterColumn(data, field.row, column);
+        }
+        else {
+            gatherColumn(macro, field.macro, column);
+            splitMissing(column, observed);
+            scatterColumn(macro, field.macro, column);
+        }
+        validity.fields[f].from_weights(observed);
+    }
+}
+
+// carries the last filled value forward where continues[i] (same series as i - 1) is 1.0
+static void forwardFill(std::vector<double>& column, std::vector<double>& filled, const std::vector<double>& continues) {
+    for (size_t i = 1; i < column.size(); ++i) {
+        double take = (1.0 - filled[i]) * continues[i] * filled[i - 1];
+        column[i] = take != 0.0 ? column[i - 1] : column[i];
+        filled[i] += take;
+    }
+}
+
+ImputationStats imputeMissing(std::vector<FinancialData>& data, std::vector<MacroData>& macro, DataValidity& validity) {
+    PROFILE_SCOPE("imputeMissing");
+    ImputationStats stats;
+    if (validity.fields.empty()) return stats;
+    const size_t n = data.size(), P = macro.size();
+
+    // 1.0 where a row continues the previous row's symbol
+    std::vector<double> continues(n, 0.0);
+    for (size_t i = 1; i < n; ++i) {
+        continues[i] = static_cast<double>(data[i].symbol == data[i - 1].symbol);
+    }
+    // rows of each period (counting sort), for the cross-sectional medians
+    std::vector<size_t> offsets(P + 1, 0), by_period(n);
+    for (const auto& fd : data) ++offsets[fd.period + 1];
+    for (size_t t = 0; t < P; ++t) offsets[t + 1] += offsets[t];
+    std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t r = 0; r < n; ++r) by_period[cursor[data[r].period]++] = r;
+    const std::vector<double> macro_continues(P, 1.0);
+
+    std::vector<double> column, observed, filled, scratch;
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        const FeatureField& field = featureSchema[f];
+        ValidityMask& mask = validity.fields[f];
+        if (mask.all() || isPriceField(field)) continue;
+        mask.to_weights(observed);
+        filled = observed;
+
+        if (field.row) {
+            stats.missing += n - mask.count();
+            gatherColumn(data, field.row, column);
+            forwardFill(column, filled, continues);
+            stats.forward_filled += static_cast<size_t>(sumOf(filled) - sumOf(observed));
+
+            // leading gaps: median of the values observed that month
+            for (size_t t = 0; t < P; ++t) {
+                scratch.clear();
+                size_t gaps = 0;
+                for (size_t k = offsets[t]; k < offsets[t + 1]; ++k) {
+                    size_t r = by_period[k];
+                    if (observed[r] != 0.0) scratch.push_back(column[r]);
+                    gaps += filled[r] == 0.0;
+                }
+                if (gaps == 0) continue;
+                if (scratch.empty()) {
+                    stats.unfilled += gaps;
+                    continue;
+                }
+                double median = medianOf(scratch);
+                for (size_t k = offsets[t]; k < offsets[t + 1]; ++k) {
+                    size_t r = by_period[k];
+                    column[r] = filled[r] != 0.0 ? column[r] : median;
+                    filled[r] = 1.0;
+                }
+                stats.median_filled += gaps;
+            }
+            scatterColumn(data, field.row, column);
+        }
+        else {
+            stats.missing += P - mask.count();
+            gatherColumn(macro, field.macro, column);
+            forwardFill(column, filled, macro_continues);
+            // leading gap: no past value to carry, left missing (normalized to the mean)
+            size_t first = std::find(filled.begin(), filled.end(), 1.0) - filled.begin();
+            stats.unfilled += first;
+            if (first == P) continue;
+            stats.forward_filled += static_cast<size_t>(sumOf(filled) - sumOf(observed));
+            scatterColumn(macro, field.macro, column);
+        }
+        mask.from_weights(filled);
+    }
+    return stats;
+}
+
+// z-score over observed values: x -> (x - mean) * scale, scale 0 for a constant column
+struct ColumnScale {
+    double mean;
+    double scale;
+};
+
+static ColumnScale observedScale(const std::vector<double>& column, const std::vector<double>& observed) {
+    double count = 0.0, sum = 0.0;
+    for (size_t i = 0; i < column.size(); ++i) {
+        count += observed[i];
+        sum += observed[i] * column[i];
+    }
+    double mean = count > 0.0 ? sum / count : 0.0;
+    double variance = 0.0;
+    for (size_t i = 0; i < column.size(); ++i) {
+        double d = column[i] - mean;
+        variance += observed[i] * d * d;
+    }
+    double stddev = count > 0.0 ? std::sqrt(variance / count) : 0.0;
+    return { mean, stddev != 0 ? 1.0 / stddev : 0.0 };
+}
+
+// missing -> 0.0
+static void normalizeColumn(std::vector<double>& column, const std::vector<double>& observed) {
+    ColumnScale s = observedScale(column, observed);
+    for (size_t i = 0; i < column.size(); ++i) {
+        column[i] = (column[i] - s.mean) * s.scale * observed[i];
+    }
+}
+
+void normalizeData(std::vector<FinancialData>& data, std::vector<MacroData>& macro, const DataValidity& validity) {
+    if (validity.fields.empty()) {
+        normalizeData(data, macro);
+        return;
+    }
+    PROFILE_SCOPE("normalizeData");
+    // moments of each row field on its own task (reads only), then rows are rewritten in
+    // blocks so no two tasks write the same record
+    std::vector<size_t> row_fields;
+    std::vector<ColumnScale> scales(featureSchemaSize);
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        if (featureSchema[f].row) row_fields.push_back(f);
+    }
+    parallelFor(row_fields.size(), 0, [&](size_t k) {
+        const size_t f = row_fields[k];
+        std::vector<double> column, observed;
+        validity.fields[f].to_weights(observed);
+        gatherColumn(data, featureSchema[f].row, column);
+        scales[f] = observedScale(column, observed);
+    });
+    const size_t block = 4096;
+    parallelFor((data.size() + block - 1) / block, 0, [&](size_t b) {
+        const size_t end = std::min(data.size(), (b + 1) * block);
+        for (size_t f : row_fields) {
+            double FinancialData::* member = featureSchema[f].row;
+            const ValidityMask& mask = validity.fields[f];
+            const ColumnScale& s = scales[f];
+            for (size_t i = b * block; i < end; ++i) {
+                double& x = data[i].*member;
+                x = (x - s.mean) * s.scale * static_cast<double>(mask.test(i));
+            }
+        }
+    });
+
+    // one value per month, small
+    std::vector<double> column, observed;
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        const FeatureField& field = featureSchema[f];
+        if (field.row) continue;
+        validity.fields[f].to_weights(observed);
+        gatherColumn(macro, field.macro, column);
+        normalizeColumn(column, observed);
+        scatterColumn(macro, field.macro, column);
+    }
+}
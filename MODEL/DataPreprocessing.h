@@ -1,5 +1,68 @@
 #pragma once
 #include <vector>
 #include "FinancialData.h"
+#include "FeatureSchema.h"
 
-void normalizeData(std::vector<FinancialData>& data);
+void normalizeData(std::vector<FinancialData>& data, std::vector<MacroData>& macro);
+
+// Loaders read missing values ("", "NA", NaN in a binary file) as NaN: this sets them to
+// 0.0 and records which values were observed, one column at a time.
+void extractValidity(std::vector<FinancialData>& data, std::vector<MacroData>& macro, DataValidity& validity);
+
+struct ImputationStats {
+    size_t missing = 0;         // feature values missing after loading (prices excluded)
+    size_t forward_filled = 0;
+    size_t median_filled = 0;
+    size_t unfilled = 0;        // nothing observed to fill from, left missing
+};
+
+// Fills missing features in place and marks them valid. Rows (loader order: by symbol, then
+// date) carry the symbol's last observed value forward; leading gaps take the cross-sectional
+// median of their month. Macro series are forward-filled only: a leading gap stays missing
+// rather than take a later month's value, and normalization maps it to 0.0 (the mean).
+// Prices are not imputed: a missing price means the asset is not tradable that month.
+ImputationStats imputeMissing(std::vector<FinancialData>& data, std::vector<MacroData>& macro, DataValidity& validity);
+
+// z-score with statistics over observed values only; missing values become 0.0, which the
+// rewards' price checks read as no data
+void normalizeData(std::vector<FinancialData>& data, std::vector<MacroData>& macro, const DataValidity& validity);
+
+struct AttributeStats {
+    double mean;
+    double stddev;
+};
+
+// z-score parameters, one entry per normalized attribute (featureSchema order)
+struct NormalizationStats {
+    std::vector<AttributeStats> rows;
+    std::vector<AttributeStats> macro;
+};
+
+// Per-period cumulative sums of every attribute (shifted by its global mean to keep the
+// squares well conditioned), so the statistics of any contiguous range of periods cost
+// O(attributes) instead of a pass over the rows. With validity, only observed values count
+// (per-attribute observed counts), as in normalizeData(data, macro, validity).
+class NormalizationMoments {
+public:
+    NormalizationMoments(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+        const DataValidity& validity = DataValidity());
+
+    // rows and months with period in [first_period, last_period)
+    NormalizationStats stats(int first_period, int last_period) const;
+
+private:
+    size_t num_periods = 0;
+    size_t num_rows_attributes = 0;
+    size_t num_macro_attributes = 0;
+    std::vector<double> row_shift, macro_shift;
+    std::vector<double> row_count, row_sum, row_sum_sq;        // [periods + 1 x row attributes]
+    std::vector<double> macro_count, macro_sum, macro_sum_sq;  // [periods + 1 x macro attributes]
+};
+
+// z-score with given statistics (e.g. from the training window only), stddev 0 -> 0.0.
+// With validity, missing values become 0.0 like in normalizeData.
+void applyNormalization(std::vector<FinancialData>& data, std::vector<MacroData>& macro, const NormalizationStats& stats,
+    const DataValidity& validity = DataValidity());
+
+// validity of data[rows[0]], data[rows[1]], ... (macro masks unchanged)
+DataValidity selectRows(const DataValidity& validity, const std::vector<size_t>& rows);
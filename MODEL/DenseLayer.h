@@ -1,3 +1,8 @@
+#pragma once
+#include <vector>
+#include <random>
+#include "Profiler.h"
+
 class DenseLayer {
 public:
     int input_size;
@@ -10,19 +15,27 @@ public:
     }
 
 
-    std::vector<double> forward(const std::vector<double>& input) {
-        std::vector<double> output(output_size, 0.0);
+    std::vector<double> forward(const std::vector<double>& input) const {
+        std::vector<double> output(output_size);
+        forward(input.data(), output.data());
+        return output;
+    }
+
+    // output[output_size], no allocation
+    void forward(const double* input, double* output) const {
+        PROFILE_SCOPE("DenseLayer::forward");
         for (int i = 0; i < output_size; ++i) {
+            output[i] = 0.0;
             for (int j = 0; j < input_size; ++j) {
                 output[i] += input[j] * weights[i][j];
             }
             output[i] += biases[i];
         }
-        return output;
     }
 
     void backward(const std::vector<double>& input, const std::vector<double>& grad_output,
         std::vector<std::vector<double>>& dW, std::vector<double>& dB) {
+        PROFILE_SCOPE("DenseLayer::backward");
         dW = std::vector<std::vector<double>>(output_size, std::vector<double>(input_size, 0.0));
         for (int i = 0; i < output_size; ++i) {
             for (int j = 0; j < input_size; ++j) {
@@ -33,6 +46,17 @@ public:
         dB = grad_output;
     }
 
+    // dW is [output_size x input_size] row-major, no allocation
+    void backward(const double* input, const double* grad_output, double* dW, double* dB) const {
+        PROFILE_SCOPE("DenseLayer::backward");
+        for (int i = 0; i < output_size; ++i) {
+            for (int j = 0; j < input_size; ++j) {
+                dW[i * input_size + j] = grad_output[i] * input[j];
+            }
+            dB[i] = grad_output[i];
+        }
+    }
+
 private:
 
     void initialize_parameters() {
@@ -0,0 +1,361 @@
+#include "Distributed.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+bool parseGradientCompression(const std::string& name, GradientCompression& compression) {
+    if (name == "none") compression = GradientCompression::None;
+    else if (name == "fp32") compression = GradientCompression::Float32;
+    else if (name == "int8") compression = GradientCompression::Int8;
+    else return false;
+    return true;
+}
+
+namespace {
+
+// values per Int8 scale
+constexpr size_t int8Block = 256;
+
+// bytes a broadcast forwards at a time
+constexpr size_t broadcastPiece = 64 * 1024;
+
+struct Endpoint {
+    bool unix_socket = false;
+    std::string host;  // tcp
+    int port = 0;
+    std::string path;  // unix
+};
+
+bool parseEndpoint(const std::string& transport, int rank, int world, Endpoint& endpoint) {
+    if (transport.rfind("unix:", 0) == 0) {
+        endpoint.unix_socket = true;
+        endpoint.path = transport.substr(5) + "." + std::to_string(rank) + ".sock";
+        return endpoint.path.size() < sizeof(sockaddr_un::sun_path);
+    }
+    if (transport.rfind("tcp:", 0) != 0) return false;
+    std::vector<std::string> peers;
+    std::istringstream list(transport.substr(4));
+    std::string peer;
+    while (std::getline(list, peer, ',')) peers.push_back(peer);
+    if (peers.size() != 1 && peers.size() != static_cast<size_t>(world)) return false;
+    const std::string& address = peers.size() == 1 ? peers[0] : peers[rank];
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) return false;
+    endpoint.host = address.substr(0, colon);
+    endpoint.port = std::atoi(address.c_str() + colon + 1) + (peers.size() == 1 ? rank : 0);
+    return endpoint.port > 0;
+}
+
+// a socket bound (listen) or connected to endpoint, -1 on failure
+int openSocket(const Endpoint& endpoint, bool listen) {
+    if (endpoint.unix_socket) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, endpoint.path.c_str(), sizeof(address.sun_path) - 1);
+        if (listen) ::unlink(endpoint.path.c_str());
+        int status = listen ? ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+                            : ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        if (status != 0 || (listen && ::listen(fd, 1) != 0)) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (::getaddrinfo(endpoint.host.c_str(), std::to_string(endpoint.port).c_str(), &hints, &addresses) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        if (listen) ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        int status = listen ? ::bind(fd, a->ai_addr, a->ai_addrlen) : ::connect(fd, a->ai_addr, a->ai_addrlen);
+        if (status != 0 || (listen && ::listen(fd, 1) != 0)) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(addresses);
+    return fd;
+}
+
+// non-blocking, no Nagle delay on the small chunks
+void configureSocket(int fd, bool tcp) {
+    if (tcp) {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// rank, world and wire format, checked by the receiving side
+struct Handshake {
+    int32_t rank;
+    int32_t world;
+    int32_t compression;
+};
+
+}
+
+RingCommunicator::RingCommunicator(const DistributedConfig& config) : config_(config) {
+    if (config_.world < 1 || config_.rank < 0 || config_.rank >= config_.world) {
+        std::cerr << "Bad rank " << config_.rank << " for a world of " << config_.world << std::endl;
+        return;
+    }
+    if (config_.world == 1) {
+        ok_ = true;
+        return;
+    }
+    const int next = (config_.rank + 1) % config_.world;
+    const int prev = (config_.rank + config_.world - 1) % config_.world;
+    Endpoint self, next_endpoint;
+    if (!parseEndpoint(config_.transport, config_.rank, config_.world, self)
+        || !parseEndpoint(config_.transport, next, config_.world, next_endpoint)) {
+        std::cerr << "Bad transport: " << config_.transport
+            << " (tcp:host:port, tcp:host:port,host:port,... one per rank, unix:/path/prefix)" << std::endl;
+        return;
+    }
+
+    int listen_fd = openSocket(self, true);
+    if (listen_fd < 0) {
+        std::cerr << "Rank " << config_.rank << " cannot listen on "
+            << (self.unix_socket ? self.path : self.host + ":" + std::to_string(self.port)) << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    if (self.unix_socket) socket_path_ = self.path;
+
+    // the next rank may not be listening yet
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.timeout_ms);
+    while ((next_fd_ = openSocket(next_endpoint, false)) < 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    pollfd pending{ listen_fd, POLLIN, 0 };
+    int remaining_ms = static_cast<int>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count()));
+    if (next_fd_ >= 0 && ::poll(&pending, 1, remaining_ms) == 1) {
+        prev_fd_ = ::accept(listen_fd, nullptr, nullptr);
+    }
+    ::close(listen_fd);
+    if (next_fd_ < 0 || prev_fd_ < 0) {
+        std::cerr << "Rank " << config_.rank << " timed out joining the ring (" << (next_fd_ < 0 ? "next" : "previous")
+            << " rank missing)" << std::endl;
+        return;
+    }
+    configureSocket(next_fd_, !self.unix_socket);
+    configureSocket(prev_fd_, !self.unix_socket);
+
+    Handshake sent{ config_.rank, config_.world, static_cast<int32_t>(config_.compression) };
+    Handshake received{};
+    try {
+        exchange(reinterpret_cast<const char*>(&sent), sizeof(sent), reinterpret_cast<char*>(&received), sizeof(received));
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+    if (received.rank != prev || received.world != sent.world || received.compression != sent.compression) {
+        std::cerr << "Rank " << config_.rank << ": peer is rank " << received.rank << " of " << received.world
+            << " with another configuration (expected rank " << prev << " of " << config_.world << ")" << std::endl;
+        return;
+    }
+    stats_ = CommStats();
+    ok_ = true;
+}
+
+RingCommunicator::~RingCommunicator() {
+    if (next_fd_ >= 0) ::close(next_fd_);
+    if (prev_fd_ >= 0) ::close(prev_fd_);
+    if (!socket_path_.empty()) ::unlink(socket_path_.c_str());
+}
+
+// sends to the next rank while receiving from the previous one; both sides do the same, so
+// neither can block the other with full socket buffers
+void RingCommunicator::exchange(const char* send, size_t send_bytes, char* receive, size_t receive_bytes) {
+    size_t sent = 0, received = 0;
+    while (sent < send_bytes || received < receive_bytes) {
+        pollfd fds[2];
+        nfds_t count = 0;
+        int send_slot = -1, receive_slot = -1;
+        if (sent < send_bytes) {
+            send_slot = static_cast<int>(count);
+            fds[count++] = { next_fd_, POLLOUT, 0 };
+        }
+        if (received < receive_bytes) {
+            receive_slot = static_cast<int>(count);
+            fds[count++] = { prev_fd_, POLLIN, 0 };
+        }
+        int ready = ::poll(fds, count, config_.timeout_ms);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) {
+            throw std::runtime_error("Rank " + std::to_string(config_.rank) + ": ring transfer timed out");
+        }
+        if (send_slot >= 0 && (fds[send_slot].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            ssize_t n = ::send(next_fd_, send + sent, send_bytes - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                throw std::runtime_error("Rank " + std::to_string(config_.rank) + ": send failed: " + std::strerror(errno));
+            }
+            if (n > 0) sent += static_cast<size_t>(n);
+        }
+        if (receive_slot >= 0 && (fds[receive_slot].revents & (POLLIN | POLLERR | POLLHUP))) {
+            ssize_t n = ::recv(prev_fd_, receive + received, receive_bytes - received, 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                throw std::runtime_error("Rank " + std::to_string(config_.rank) + ": previous rank disconnected");
+            }
+            if (n > 0) received += static_cast<size_t>(n);
+        }
+    }
+    stats_.bytes_sent += send_bytes;
+}
+
+size_t RingCommunicator::encoded_size(GradientCompression compression, size_t n) {
+    switch (compression) {
+    case GradientCompression::Float32: return n * sizeof(float);
+    case GradientCompression::Int8: return (n + int8Block - 1) / int8Block * sizeof(double) + n;
+    default: return n * sizeof(double);
+    }
+}
+
+void RingCommunicator::encode(GradientCompression compression, const double* values, size_t n, char* out) {
+    if (compression == GradientCompression::Float32) {
+        for (size_t i = 0; i < n; ++i) {
+            float f = static_cast<float>(values[i]);
+            std::memcpy(out + i * sizeof(float), &f, sizeof(float));
+        }
+    }
+    else if (compression == GradientCompression::Int8) {
+        for (size_t first = 0; first < n; first += int8Block) {
+            size_t count = std::min(int8Block, n - first);
+            double max_abs = 0.0;
+            for (size_t i = 0; i < count; ++i) max_abs = std::max(max_abs, std::fabs(values[first + i]));
+            double scale = max_abs > 0.0 ? max_abs / 127.0 : 1.0;
+            std::memcpy(out, &scale, sizeof(double));
+            out += sizeof(double);
+            for (size_t i = 0; i < count; ++i) {
+                *out++ = static_cast<char>(static_cast<int8_t>(std::lround(values[first + i] / scale)));
+            }
+        }
+    }
+    else {
+        std::memcpy(out, values, n * sizeof(double));
+    }
+}
+
+void RingCommunicator::decode(GradientCompression compression, const char* in, size_t n, double* values, bool add) {
+    auto store = [&](size_t i, double x) { values[i] = add ? values[i] + x : x; };
+    if (compression == GradientCompression::Float32) {
+        for (size_t i = 0; i < n; ++i) {
+            float f;
+            std::memcpy(&f, in + i * sizeof(float), sizeof(float));
+            store(i, f);
+        }
+    }
+    else if (compression == GradientCompression::Int8) {
+        for (size_t first = 0; first < n; first += int8Block) {
+            size_t count = std::min(int8Block, n - first);
+            double scale;
+            std::memcpy(&scale, in, sizeof(double));
+            in += sizeof(double);
+            for (size_t i = 0; i < count; ++i) {
+                store(first + i, scale * static_cast<int8_t>(*in++));
+            }
+        }
+    }
+    else {
+        for (size_t i = 0; i < n; ++i) {
+            double x;
+            std::memcpy(&x, in + i * sizeof(double), sizeof(double));
+            store(i, x);
+        }
+    }
+}
+
+void RingCommunicator::allreduce(double* data, size_t n, GradientCompression compression) {
+    const int W = config_.world;
+    ++stats_.allreduces;
+    if (W == 1 || n == 0) return;
+    auto start = std::chrono::steady_clock::now();
+    auto first = [&](int chunk) { return n * static_cast<size_t>(chunk) / W; };
+    auto size = [&](int chunk) { return first(chunk + 1) - first(chunk); };
+    auto wrap = [&](int chunk) { return ((chunk % W) + W) % W; };
+    const size_t max_bytes = encoded_size(compression, n / W + 1);
+    send_buffer_.resize(max_bytes);
+    receive_buffer_.resize(max_bytes);
+
+    // reduce-scatter: after W - 1 steps this rank holds the full sum of chunk rank + 1
+    for (int step = 0; step < W - 1; ++step) {
+        int send_chunk = wrap(config_.rank - step);
+        int receive_chunk = wrap(config_.rank - step - 1);
+        encode(compression, data + first(send_chunk), size(send_chunk), send_buffer_.data());
+        exchange(send_buffer_.data(), encoded_size(compression, size(send_chunk)), receive_buffer_.data(), encoded_size(compression, size(receive_chunk)));
+        decode(compression, receive_buffer_.data(), size(receive_chunk), data + first(receive_chunk), true);
+    }
+
+    // allgather: the owner keeps its chunk as decoded from the bytes it sends, and the other
+    // ranks forward the bytes they received, so every rank decodes the same bytes
+    int own = wrap(config_.rank + 1);
+    encode(compression, data + first(own), size(own), send_buffer_.data());
+    decode(compression, send_buffer_.data(), size(own), data + first(own), false);
+    for (int step = 0; step < W - 1; ++step) {
+        int send_chunk = wrap(config_.rank + 1 - step);
+        int receive_chunk = wrap(config_.rank - step);
+        exchange(send_buffer_.data(), encoded_size(compression, size(send_chunk)), receive_buffer_.data(), encoded_size(compression, size(receive_chunk)));
+        decode(compression, receive_buffer_.data(), size(receive_chunk), data + first(receive_chunk), false);
+        std::swap(send_buffer_, receive_buffer_);
+    }
+    stats_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// rank 0 -> 1 -> ... -> world - 1 in pieces: a rank forwards piece k - 1 while it receives
+// piece k, so a hop costs one piece of latency rather than the whole transfer
+void RingCommunicator::broadcast(std::string& bytes) {
+    if (config_.world == 1) return;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t length = bytes.size();
+    const bool forwards = config_.rank < config_.world - 1;
+    if (config_.rank == 0) {
+        exchange(reinterpret_cast<const char*>(&length), sizeof(length), nullptr, 0);
+        exchange(bytes.data(), bytes.size(), nullptr, 0);
+    }
+    else {
+        exchange(nullptr, 0, reinterpret_cast<char*>(&length), sizeof(length));
+        bytes.resize(length);
+        if (forwards) {
+            exchange(reinterpret_cast<const char*>(&length), sizeof(length), nullptr, 0);
+        }
+        const size_t pieces = (length + broadcastPiece - 1) / broadcastPiece;
+        auto size = [&](size_t piece) { return std::min<size_t>(broadcastPiece, length - piece * broadcastPiece); };
+        for (size_t piece = 0; piece <= pieces; ++piece) {
+            const bool send = forwards && piece > 0;
+            const bool receive = piece < pieces;
+            exchange(send ? &bytes[(piece - 1) * broadcastPiece] : nullptr, send ? size(piece - 1) : 0,
+                receive ? &bytes[piece * broadcastPiece] : nullptr, receive ? size(piece) : 0);
+        }
+    }
+    stats_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
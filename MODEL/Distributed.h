@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "ThreadPool.h"
+
+// Collectives between trainer processes connected in a ring, each rank talking to
+// rank + 1 (sends) and rank - 1 (receives) over TCP or Unix domain sockets (POSIX only).
+// Buffers go over the wire in the host's byte order, so all ranks need the same one.
+//
+//   tcp:127.0.0.1:29500          every rank on one host, rank r listens on port 29500 + r
+//   tcp:hostA:29500,hostB:29500  one host:port per rank
+//   unix:/tmp/portfolio          rank r listens on /tmp/portfolio.r.sock
+
+// wire format of allreduce chunks. Float32 halves the bytes, Int8 sends one byte per value
+// plus a scale per 256 values; both are lossy, the result is still identical on every rank.
+enum class GradientCompression { None, Float32, Int8 };
+
+bool parseGradientCompression(const std::string& name, GradientCompression& compression);
+
+struct DistributedConfig {
+    int rank = 0;
+    int world = 1;
+    std::string transport = "tcp:127.0.0.1:29500";
+    GradientCompression compression = GradientCompression::None;
+    bool overlap = false;              // communication of step k runs while step k + 1 computes
+    int timeout_ms = 60000;            // connecting to the ring, then per transfer without progress
+};
+
+struct CommStats {
+    size_t allreduces = 0;
+    uint64_t bytes_sent = 0;
+    double seconds = 0.0;  // inside collectives
+};
+
+class RingCommunicator {
+public:
+    // binds, connects to the next rank and accepts the previous one (retrying until timeout_ms)
+    explicit RingCommunicator(const DistributedConfig& config);
+    ~RingCommunicator();
+
+    RingCommunicator(const RingCommunicator&) = delete;
+    RingCommunicator& operator=(const RingCommunicator&) = delete;
+
+    bool ok() const { return ok_; }
+    int rank() const { return config_.rank; }
+    int world() const { return config_.world; }
+    const CommStats& stats() const { return stats_; }
+
+    // Element-wise sum over the ranks, in place, bit-identical on every rank: reduce-scatter
+    // then allgather around the ring, each rank sending 2 (world - 1) / world of the buffer.
+    // One collective at a time; throws std::runtime_error when a peer fails.
+    void allreduce(double* data, size_t n, GradientCompression compression);
+    // with the configured compression
+    void allreduce(double* data, size_t n) { allreduce(data, n, config_.compression); }
+    void allreduce(std::vector<double>& data) { allreduce(data.data(), data.size()); }
+
+    // rank 0's bytes replace `bytes` on every rank
+    void broadcast(std::string& bytes);
+
+private:
+    void exchange(const char* send, size_t send_bytes, char* receive, size_t receive_bytes);
+    static size_t encoded_size(GradientCompression compression, size_t n);
+    static void encode(GradientCompression compression, const double* values, size_t n, char* out);
+    static void decode(GradientCompression compression, const char* in, size_t n, double* values, bool add);
+
+    DistributedConfig config_;
+    bool ok_ = false;
+    int next_fd_ = -1;
+    int prev_fd_ = -1;
+    std::string socket_path_;  // unix transport, removed on destruction
+    std::vector<char> send_buffer_, receive_buffer_;
+    CommStats stats_;
+};
+
+// Collectives started on a pool worker, so the caller can compute the next step meanwhile.
+// Their buffers must stay untouched until wait().
+class PendingAllreduce {
+public:
+    template <typename F>
+    void start(F&& collectives) {
+        active = true;
+        group.run(std::forward<F>(collectives));
+    }
+
+    // false when nothing was started
+    bool wait() {
+        if (!active) return false;
+        group.wait();
+        active = false;
+        return true;
+    }
+
+private:
+    TaskGroup group;
+    bool active = false;
+};
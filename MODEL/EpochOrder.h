@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include "ExplorationPolicy.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PORTFOLIO_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PORTFOLIO_PREFETCH(address) ((void)(address))
+#endif
+
+// Visit order of one epoch over rows that never move: shuffling permutes 4-byte indices
+// instead of swapping FinancialData records (two std::strings each).
+// block_size 0 = uniform permutation. Otherwise the base order is cut into blocks of
+// block_size rows, visited in random order and shuffled within, so consecutive visits stay
+// close in memory (loader order: a block is consecutive months of one symbol).
+class EpochOrder {
+public:
+    static constexpr size_t prefetch_distance = 8;  // rows ahead
+
+    EpochOrder() = default;
+    explicit EpochOrder(size_t count, size_t block_size = 0) : block_size(block_size), rows(count) {
+        std::iota(rows.begin(), rows.end(), 0u);
+        order = rows;
+    }
+    // a subset of the rows (e.g. the training rows), in their base order
+    EpochOrder(const std::vector<size_t>& subset, size_t block_size = 0)
+        : block_size(block_size), rows(subset.begin(), subset.end()), order(rows) {}
+
+    void shuffle(RngStream& rng) {
+        order = rows;
+        if (block_size == 0 || block_size >= rows.size()) {
+            shuffleRange(order.data(), order.size(), rng);
+            return;
+        }
+        blocks.resize((rows.size() + block_size - 1) / block_size);
+        std::iota(blocks.begin(), blocks.end(), 0u);
+        shuffleRange(blocks.data(), blocks.size(), rng);
+        size_t k = 0;
+        for (uint32_t b : blocks) {
+            size_t first = b * block_size, count = std::min(block_size, rows.size() - first);
+            std::copy(rows.begin() + first, rows.begin() + first + count, order.begin() + k);
+            shuffleRange(order.data() + k, count, rng);
+            k += count;
+        }
+    }
+
+    size_t size() const { return order.size(); }
+    uint32_t operator[](size_t k) const { return order[k]; }
+    const std::vector<uint32_t>& indices() const { return order; }
+
+    // every cache line of the record visited prefetch_distance steps after position k
+    template <typename Record>
+    void prefetch(const std::vector<Record>& records, size_t k) const {
+        size_t ahead = k + prefetch_distance;
+        if (ahead >= order.size()) return;
+        const char* record = reinterpret_cast<const char*>(&records[order[ahead]]);
+        for (size_t offset = 0; offset < sizeof(Record); offset += 64) {
+            PORTFOLIO_PREFETCH(record + offset);
+        }
+    }
+
+private:
+    // Fisher-Yates
+    static void shuffleRange(uint32_t* first, size_t count, RngStream& rng) {
+        for (size_t i = count; i > 1; --i) {
+            std::swap(first[i - 1], first[rng.next() % i]);
+        }
+    }
+
+    size_t block_size = 0;
+    std::vector<uint32_t> rows;    // base order
+    std::vector<uint32_t> order;   // this epoch
+    std::vector<uint32_t> blocks;
+};
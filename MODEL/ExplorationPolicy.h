@@ -0,0 +1,284 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <random>
+#include <algorithm>
+
+// xoshiro256**, one independent stream per jump (2^128 draws apart)
+class RngStream {
+public:
+    RngStream(uint64_t seed, uint64_t stream) {
+        for (auto& word : s) {
+            seed += 0x9e3779b97f4a7c15ULL; // splitmix64
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+        for (uint64_t i = 0; i < stream; ++i) {
+            jump();
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // (0, 1), never exactly 0 so logs are safe
+    double uniform() { return ((next() >> 11) + 0.5) * 0x1.0p-53; }
+
+    void fill_uniform(double* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = uniform();
+        }
+    }
+
+    double normal() {
+        // Box-Muller, one value per call
+        double u1 = uniform();
+        double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+
+    // Marsaglia-Tsang, alpha > 0
+    double gamma(double alpha) {
+        if (alpha < 1.0) {
+            return gamma(alpha + 1.0) * std::pow(uniform(), 1.0 / alpha);
+        }
+        double d = alpha - 1.0 / 3.0;
+        double c = 1.0 / std::sqrt(9.0 * d);
+        while (true) {
+            double x = normal();
+            double v = 1.0 + c * x;
+            if (v <= 0.0) continue;
+            v = v * v * v;
+            double u = uniform();
+            if (std::log(u) < 0.5 * x * x + d - d * v + d * std::log(v)) {
+                return d * v;
+            }
+        }
+    }
+
+    void jump() {
+        static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+        uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (uint64_t j : JUMP) {
+            for (int b = 0; b < 64; ++b) {
+                if (j & (1ULL << b)) {
+                    s0 ^= s[0];
+                    s1 ^= s[1];
+                    s2 ^= s[2];
+                    s3 ^= s[3];
+                }
+                next();
+            }
+        }
+        s[0] = s0;
+        s[1] = s1;
+        s[2] = s2;
+        s[3] = s3;
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// per-thread stream, threads get consecutive stream ids from one process seed
+inline RngStream& thread_rng() {
+    static const uint64_t seed = (uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+    static std::atomic<uint64_t> next_stream{ 0 };
+    thread_local RngStream rng(seed, next_stream.fetch_add(1));
+    return rng;
+}
+
+// Portfolio allocation: weights ~ Dirichlet(concentration * scores / sum(scores)) over a batch
+// of symbols. High concentration stays close to the model's scores, low spreads the bets.
+class DirichletAllocationPolicy {
+public:
+    double concentration;
+    double min_alpha;
+
+    DirichletAllocationPolicy(double concentration, double min_alpha = 1e-3)
+        : concentration(concentration), min_alpha(min_alpha) {}
+
+    void allocate(const std::vector<double>& scores, std::vector<double>& weights, RngStream& rng = thread_rng()) {
+        weights.resize(scores.size());
+        double total = 0.0;
+        for (double s : scores) {
+            total += std::max(s, 0.0);
+        }
+        double scale = total > 0.0 ? concentration / total : 0.0;
+
+        double sum = 0.0;
+        for (size_t i = 0; i < scores.size(); ++i) {
+            weights[i] = rng.gamma(std::max(std::max(scores[i], 0.0) * scale, min_alpha));
+            sum += weights[i];
+        }
+        double inv = sum > 0.0 ? 1.0 / sum : 0.0;
+        for (double& w : weights) {
+            w *= inv;
+        }
+    }
+};
+
+enum class PolicyKind { EpsilonGreedy, Boltzmann, GumbelMax, Dirichlet };
+
+inline bool parsePolicyKind(const std::string& name, PolicyKind& kind) {
+    if (name == "epsilon") kind = PolicyKind::EpsilonGreedy;
+    else if (name == "boltzmann") kind = PolicyKind::Boltzmann;
+    else if (name == "gumbel") kind = PolicyKind::GumbelMax;
+    else if (name == "dirichlet") kind = PolicyKind::Dirichlet;
+    else return false;
+    return true;
+}
+
+// Batched action selection: probs is [batch x num_actions] row-major softmax output,
+// one call picks an action for every symbol of the batch. Random numbers are drawn
+// into a scratch buffer first so the selection loops stay branch-free.
+// Dirichlet needs the batch to be the symbols of one month: it allocates across them, so a
+// one-row call always holds.
+// rows scored before one select_actions call in the loops without a natural batch (a month,
+// a trajectory): windows of the shuffled order in the search and --stream
+constexpr size_t selectionWindow = 64;
+
+class ExplorationPolicy {
+public:
+    PolicyKind kind;
+    double epsilon;        // epsilon-greedy exploration rate
+    double temperature;    // boltzmann / gumbel sharpness, 1.0 = sample the learned distribution
+    double concentration;  // dirichlet, per symbol of the batch: higher stays closer to the model
+    int hold_action = 0;   // dirichlet, the action read as "hold the asset"
+
+    ExplorationPolicy(PolicyKind kind, double eps, double temperature = 1.0, double concentration = 10.0)
+        : kind(kind), epsilon(eps), temperature(temperature), concentration(concentration), allocation(concentration) {}
+
+    void select_actions(const std::vector<double>& probs, size_t num_actions, std::vector<int>& actions,
+        RngStream& rng = thread_rng()) {
+        size_t batch = probs.size() / num_actions;
+        actions.resize(batch);
+        select(probs.data(), batch, num_actions, actions.data(), rng);
+    }
+
+    void select_actions(const double* probs, size_t batch, size_t num_actions, int* actions, RngStream& rng = thread_rng()) {
+        select(probs, batch, num_actions, actions, rng);
+    }
+
+    int select_action(const std::vector<double>& action_probs, RngStream& rng = thread_rng()) {
+        return select_action(action_probs.data(), action_probs.size(), rng);
+    }
+
+    int select_action(const double* action_probs, size_t num_actions, RngStream& rng = thread_rng()) {
+        int action = 0;
+        select(action_probs, 1, num_actions, &action, rng);
+        return action;
+    }
+
+    void decay_epsilon(double decay_rate) {
+        epsilon *= decay_rate;
+    }
+
+private:
+    std::vector<double> noise;
+    DirichletAllocationPolicy allocation;
+    std::vector<double> scores, weights;
+
+    void select(const double* probs, size_t batch, size_t num_actions, int* actions, RngStream& rng) {
+        switch (kind) {
+        case PolicyKind::Boltzmann: boltzmann(probs, batch, num_actions, actions, rng); break;
+        case PolicyKind::GumbelMax: gumbel_max(probs, batch, num_actions, actions, rng); break;
+        case PolicyKind::Dirichlet: dirichlet(probs, batch, num_actions, actions, rng); break;
+        case PolicyKind::EpsilonGreedy:
+        default: epsilon_greedy(probs, batch, num_actions, actions, rng); break;
+        }
+    }
+
+    static int argmax(const double* row, size_t n) {
+        int best = 0;
+        for (size_t a = 1; a < n; ++a) {
+            best = row[a] > row[best] ? static_cast<int>(a) : best;
+        }
+        return best;
+    }
+
+    void epsilon_greedy(const double* probs, size_t batch, size_t num_actions, int* actions, RngStream& rng) {
+        noise.resize(2 * batch);
+        rng.fill_uniform(noise.data(), noise.size());
+        for (size_t b = 0; b < batch; ++b) {
+            int greedy = argmax(probs + b * num_actions, num_actions);
+            int random = std::min(static_cast<int>(noise[batch + b] * num_actions), static_cast<int>(num_actions) - 1);
+            actions[b] = noise[b] < epsilon ? random : greedy;
+        }
+    }
+
+    // inverse CDF over p^(1/T)
+    void boltzmann(const double* probs, size_t batch, size_t num_actions, int* actions, RngStream& rng) {
+        noise.resize(batch + batch * num_actions);
+        rng.fill_uniform(noise.data(), batch);
+        double* weights = noise.data() + batch;
+        double inv_t = 1.0 / temperature;
+        for (size_t i = 0; i < batch * num_actions; ++i) {
+            weights[i] = std::pow(probs[i], inv_t);
+        }
+        for (size_t b = 0; b < batch; ++b) {
+            const double* w = weights + b * num_actions;
+            double total = 0.0;
+            for (size_t a = 0; a < num_actions; ++a) {
+                total += w[a];
+            }
+            double target = noise[b] * total;
+            double cumulative = 0.0;
+            int action = 0;
+            for (size_t a = 0; a + 1 < num_actions; ++a) {
+                cumulative += w[a];
+                action += cumulative < target;
+            }
+            actions[b] = action;
+        }
+    }
+
+    // argmax(log p / T + Gumbel noise)
+    void gumbel_max(const double* probs, size_t batch, size_t num_actions, int* actions, RngStream& rng) {
+        noise.resize(batch * num_actions);
+        rng.fill_uniform(noise.data(), noise.size());
+        double inv_t = 1.0 / temperature;
+        for (size_t i = 0; i < noise.size(); ++i) {
+            noise[i] = std::log(std::max(probs[i], 1e-300)) * inv_t - std::log(-std::log(noise[i]));
+        }
+        for (size_t b = 0; b < batch; ++b) {
+            actions[b] = argmax(noise.data() + b * num_actions, num_actions);
+        }
+    }
+
+    // allocation ~ Dirichlet around the batch's hold probabilities: a symbol is held when its
+    // draw is at least an equal share, otherwise it takes its most likely other action
+    void dirichlet(const double* probs, size_t batch, size_t num_actions, int* actions, RngStream& rng) {
+        scores.resize(batch);
+        for (size_t b = 0; b < batch; ++b) {
+            scores[b] = probs[b * num_actions + hold_action];
+        }
+        allocation.concentration = concentration * batch;
+        allocation.allocate(scores, weights, rng);
+        const double equal_share = 1.0 / batch;
+        for (size_t b = 0; b < batch; ++b) {
+            const double* row = probs + b * num_actions;
+            int other = hold_action == 0 ? 1 : 0;
+            for (size_t a = 0; a < num_actions; ++a) {
+                other = static_cast<int>(a) != hold_action && row[a] > row[other] ? static_cast<int>(a) : other;
+            }
+            actions[b] = weights[b] >= equal_share ? hold_action : other;
+        }
+    }
+};
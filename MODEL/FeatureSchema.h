@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include "FinancialData.h"
+#include "ValidityMask.h"
+
+// which LTC sub-network reads a field, None = kept but not a model input
+enum class FeatureGroup { None, Macro, Accounting, Market };
+
+struct FeatureField {
+    const char* name;          // attribute name
+    const char* csv_column;    // header in financial_data.csv, nullptr = derived by the loader
+    FeatureGroup group;
+    int input_index;           // position in the group's input vector
+    double FinancialData::* row;
+    double MacroData::* macro;
+};
+
+// Single description of every numeric field, in financial_data.csv column order (after
+// Date and Symbol). The loader, normalizeData and the input gather kernels all read it.
+inline constexpr FeatureField featureSchema[] = {
+    { "stockPrice", "Stock Price", FeatureGroup::Market, 0, &FinancialData::stockPrice, nullptr },
+    { "nextMonthStockPrice", nullptr, FeatureGroup::None, -1, &FinancialData::nextMonthStockPrice, nullptr },
+    { "interestRate", "Interest Rate", FeatureGroup::Macro, 0, nullptr, &MacroData::interestRate },
+    { "unemploymentRate", "Unemployment Rate", FeatureGroup::Macro, 1, nullptr, &MacroData::unemploymentRate },
+    { "inflation", "Inflation", FeatureGroup::Macro, 2, nullptr, &MacroData::inflation },
+    { "growthRate", "Growth Rate", FeatureGroup::Macro, 3, nullptr, &MacroData::growthRate },
+    { "consumerSentiment", "Consumer Sentiment", FeatureGroup::Macro, 4, nullptr, &MacroData::consumerSentiment },
+    { "sectorSentiment", "Sector Sentiment", FeatureGroup::Market, 1, &FinancialData::sectorSentiment, nullptr },
+    { "salesFigures", "Sales Figures", FeatureGroup::Accounting, 0, &FinancialData::salesFigures, nullptr },
+    { "grossMargin", "Gross Margin", FeatureGroup::Accounting, 1, &FinancialData::grossMargin, nullptr },
+    { "selfFinancingCapacity", "Self Financing Capacity", FeatureGroup::Accounting, 2, &FinancialData::selfFinancingCapacity, nullptr },
+    { "netIncome", "Net Income", FeatureGroup::Accounting, 3, &FinancialData::netIncome, nullptr },
+    { "profitPerStock", "Profit Per Stock", FeatureGroup::Accounting, 4, &FinancialData::profitPerStock, nullptr },
+    { "freeCashFlow", "Free Cash Flow", FeatureGroup::Accounting, 5, &FinancialData::freeCashFlow, nullptr },
+    { "netDebtToEquity", "Net Debt to Equity", FeatureGroup::Accounting, 6, &FinancialData::netDebtToEquity, nullptr },
+    { "roa", "ROA", FeatureGroup::Accounting, 7, &FinancialData::roa, nullptr },
+    { "ebitda", "EBITDA", FeatureGroup::Accounting, 8, &FinancialData::ebitda, nullptr },
+    { "pricingDCF", "Pricing DCF", FeatureGroup::None, -1, &FinancialData::pricingDCF, nullptr },
+    { "sharpeRatio", "Sharpe Ratio", FeatureGroup::Market, 4, &FinancialData::sharpeRatio, nullptr },
+    { "cagr", "CAGR", FeatureGroup::Market, 5, &FinancialData::cagr, nullptr },
+    { "var", "VaR", FeatureGroup::Market, 6, &FinancialData::var, nullptr },
+    { "cvar", "CVaR", FeatureGroup::Market, 7, &FinancialData::cvar, nullptr },
+    { "beta", "Beta", FeatureGroup::Market, 2, &FinancialData::beta, nullptr },
+    { "dividendYield", "Dividend Yield", FeatureGroup::Market, 3, &FinancialData::dividendYield, nullptr },
+};
+
+inline constexpr size_t featureSchemaSize = sizeof(featureSchema) / sizeof(featureSchema[0]);
+
+constexpr int featureCount(FeatureGroup group) {
+    int count = 0;
+    for (const auto& field : featureSchema) {
+        count += field.group == group;
+    }
+    return count;
+}
+
+// Null bitmaps of a loaded dataset, one per featureSchema entry: bit r of a row field is
+// data[r], bit t of a macro field is macro[t]. Empty = everything observed.
+struct DataValidity {
+    std::vector<ValidityMask> fields;  // [featureSchemaSize]
+};
+
+// preallocated [batch x group width] input blocks, reused across batches
+struct InputTiles {
+    size_t batch = 0;
+    std::vector<double> macro;       // [batch x featureCount(Macro)]
+    std::vector<double> accounting;  // [batch x featureCount(Accounting)]
+    std::vector<double> market;      // [batch x featureCount(Market)]
+
+    void resize(size_t rows) {
+        batch = rows;
+        macro.resize(rows * featureCount(FeatureGroup::Macro));
+        accounting.resize(rows * featureCount(FeatureGroup::Accounting));
+        market.resize(rows * featureCount(FeatureGroup::Market));
+    }
+};
+
+// One field, resolved at compile time: a plain load and store, or nothing.
+template <FeatureGroup Group, size_t I>
+inline void gatherField(const FinancialData& fd, const MacroData& md, double* out) {
+    constexpr const FeatureField& field = featureSchema[I];
+    if constexpr (field.group == Group) {
+        if constexpr (field.row != nullptr) {
+            out[field.input_index] = fd.*(field.row);
+        }
+        else {
+            out[field.input_index] = md.*(field.macro);
+        }
+    }
+}
+
+template <FeatureGroup Group, size_t... I>
+inline void gatherRow(const FinancialData& fd, const MacroData& md, double* out, std::index_sequence<I...>) {
+    (gatherField<Group, I>(fd, md, out), ...);
+}
+
+// tile[b] = group inputs of data[rows[b]]
+template <FeatureGroup Group>
+inline void gatherTile(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+    const size_t* rows, size_t batch, double* tile) {
+    constexpr int width = featureCount(Group);
+    for (size_t b = 0; b < batch; ++b) {
+        const FinancialData& fd = data[rows[b]];
+        gatherRow<Group>(fd, macro[fd.period], tile + b * width, std::make_index_sequence<featureSchemaSize>{});
+    }
+}
+
+inline void gatherInputs(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+    const size_t* rows, size_t batch, InputTiles& tiles) {
+    tiles.resize(batch);
+    gatherTile<FeatureGroup::Macro>(data, macro, rows, batch, tiles.macro.data());
+    gatherTile<FeatureGroup::Accounting>(data, macro, rows, batch, tiles.accounting.data());
+    gatherTile<FeatureGroup::Market>(data, macro, rows, batch, tiles.market.data());
+}
@@ -2,16 +2,22 @@
 #pragma once
 #include <string>
 
-struct FinancialData {
+// macro series are the same for every symbol of a month, stored once per date
+struct MacroData {
     std::string date;
-    std::string symbol;
-    double stockPrice;
-    double nextMonthStockPrice;
     double interestRate;
     double unemploymentRate;
     double inflation;
     double growthRate;
     double consumerSentiment;
+};
+
+struct FinancialData {
+    std::string date;
+    std::string symbol;
+    int period;  // index of date in the MacroData table
+    double stockPrice;
+    double nextMonthStockPrice;
     double sectorSentiment;
     double salesFigures;
     double grossMargin;
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include "LTC.h"
+
+// Several LTCCells stepped as one block-diagonal cell. Parameters of all cells are packed
+// into flat arrays (each W block row-major, back to back) and the states of all cells live
+// in one buffer laid out like the concat of the individual states, so the result can be
+// written straight into the buffer DenseLayer reads. Same arithmetic as LTCCell::ode_step.
+class FusedLTCExecutor {
+public:
+    int total_units = 0;
+    int ode_solver_unfolds = 6;
+    ODESolver solver = ODESolver::SemiImplicit;
+    AdaptiveODEConfig adaptive;
+    ODEStats ode_stats;  // ODESolver::Adaptive only, summed over step() calls
+
+    FusedLTCExecutor() = default;
+
+    explicit FusedLTCExecutor(const std::vector<const LTCCell*>& cells) {
+        pack(cells);
+    }
+
+    // copies the cells' parameters, call again after they change
+    void pack(const std::vector<const LTCCell*>& cells) {
+        total_units = 0;
+        blocks.clear();
+        W.clear();
+        cm_t.clear();
+        leak.clear();
+        gleak.clear();
+        denominator.clear();
+        for (const LTCCell* cell : cells) {
+            Block block;
+            block.offset = total_units;
+            block.units = cell->num_units;
+            block.weights = W.size();
+            blocks.push_back(block);
+
+            for (int i = 0; i < cell->num_units; ++i) {
+                W.insert(W.end(), cell->W[i].begin(), cell->W[i].end());
+                cm_t.push_back(cell->cm_t[i]);
+                leak.push_back(cell->gleak[i] * cell->vleak[i]);
+                gleak.push_back(cell->gleak[i]);
+                denominator.push_back(cell->cm_t[i] + cell->gleak[i]);
+            }
+            total_units += cell->num_units;
+            ode_solver_unfolds = cell->ode_solver_unfolds;
+            solver = cell->solver;
+            adaptive = cell->adaptive;
+        }
+        activation.resize(total_units);
+        scratch.resize(total_units);
+        adaptive_scratch.resize(total_units);
+    }
+
+    // state and out are [total_units], in concat order; they may alias
+    void step(const double* state, double* out) {
+        PROFILE_SCOPE("FusedLTCExecutor::step");
+        if (solver == ODESolver::Adaptive) {
+            step_adaptive(state, out);
+            return;
+        }
+        PROFILE_COUNT("ltc.unit_updates", ode_solver_unfolds * total_units);
+        const double* v = state;
+        for (int t = 0; t < ode_solver_unfolds; ++t) {
+            // every unit of every cell in one loop
+            for (int j = 0; j < total_units; ++j) {
+                activation[j] = sigmoid(v[j]);
+            }
+            double* next = (t == ode_solver_unfolds - 1) ? out : scratch.data();
+            for (const Block& block : blocks) {
+                const double* w = &W[block.weights];
+                const double* act = &activation[block.offset];
+                for (int i = 0; i < block.units; ++i) {
+                    double weighted_sum = 0.0;
+                    for (int j = 0; j < block.units; ++j) {
+                        weighted_sum += w[i * block.units + j] * act[j];
+                    }
+                    int u = block.offset + i;
+                    next[u] = (cm_t[u] * v[u] + leak[u] + weighted_sum) / denominator[u];
+                }
+            }
+            v = next;
+        }
+        if (ode_solver_unfolds == 0 && out != state) {
+            std::copy(state, state + total_units, out);
+        }
+    }
+
+    void step(const std::vector<double>& state, std::vector<double>& out) {
+        out.resize(total_units);
+        step(state.data(), out.data());
+    }
+
+private:
+    // one error-controlled integration of the whole block-diagonal system (shared step size)
+    void step_adaptive(const double* state, double* out) {
+        if (out != state) {
+            std::copy(state, state + total_units, out);
+        }
+        ODEStats call;
+        integrateAdaptive(out, total_units, ode_solver_unfolds, cm_t.data(), gleak.data(), leak.data(), adaptive,
+            [this](const double* v, double* synapse) {
+                for (int j = 0; j < total_units; ++j) {
+                    activation[j] = sigmoid(v[j]);
+                }
+                for (const Block& block : blocks) {
+                    const double* w = &W[block.weights];
+                    const double* act = &activation[block.offset];
+                    for (int i = 0; i < block.units; ++i) {
+                        double weighted_sum = 0.0;
+                        for (int j = 0; j < block.units; ++j) {
+                            weighted_sum += w[i * block.units + j] * act[j];
+                        }
+                        synapse[block.offset + i] = weighted_sum;
+                    }
+                }
+            }, adaptive_scratch, call);
+        ode_stats.add(call);
+        PROFILE_COUNT("ltc.unit_updates", call.evaluations * total_units);
+    }
+
+    struct Block {
+        int offset;      // first unit in the fused state
+        int units;
+        size_t weights;  // first entry in W
+    };
+
+    std::vector<Block> blocks;
+    std::vector<double> W;
+    std::vector<double> cm_t, leak, gleak, denominator;
+    std::vector<double> activation, scratch;
+    AdaptiveODEScratch adaptive_scratch;
+};
@@ -0,0 +1,400 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include "PortfolioModel.h"
+#include "AdamOptimizer.h"
+#include "ExplorationPolicy.h"
+#include "Backtest.h"
+#include "EpochOrder.h"
+#include "RewardFunction.h"
+#include "ThreadPool.h"
+
+// every knob of a training run
+struct Hyperparameters {
+    int num_units_macro = 5;
+    int num_units_accounting = 5;
+    int num_units_market = 5;
+    int ode_solver_unfolds = 6;
+    ODESolver solver = ODESolver::SemiImplicit;  // Adaptive: the unfolds are the horizon
+    AdaptiveODEConfig ode;
+    double learning_rate = 0.001;
+    double beta1 = 0.9;
+    double beta2 = 0.999;
+    double epsilon = 0.1;         // exploration
+    double epsilon_decay = 0.995;
+    int epochs = 10;
+};
+
+struct SearchSpace {
+    int min_units = 2, max_units = 16;
+    int min_unfolds = 1, max_unfolds = 12;
+    double min_learning_rate = 1e-4, max_learning_rate = 1e-1;  // log-uniform
+    double min_beta1 = 0.8, max_beta1 = 0.99;
+    double min_beta2 = 0.99, max_beta2 = 0.9999;                // log-uniform in 1 - beta2
+    double min_epsilon = 0.01, max_epsilon = 0.3;
+    double min_epsilon_decay = 0.9, max_epsilon_decay = 1.0;
+    ODESolver solver = ODESolver::SemiImplicit;  // fixed, copied into every sample
+    AdaptiveODEConfig ode;
+
+    Hyperparameters sample(RngStream& rng) const {
+        auto integer = [&](int lo, int hi) { return lo + static_cast<int>(rng.next() % static_cast<uint64_t>(hi - lo + 1)); };
+        auto uniform = [&](double lo, double hi) { return lo + (hi - lo) * rng.uniform(); };
+        auto log_uniform = [&](double lo, double hi) { return std::exp(uniform(std::log(lo), std::log(hi))); };
+
+        Hyperparameters params;
+        params.num_units_macro = integer(min_units, max_units);
+        params.num_units_accounting = integer(min_units, max_units);
+        params.num_units_market = integer(min_units, max_units);
+        params.ode_solver_unfolds = integer(min_unfolds, max_unfolds);
+        params.solver = solver;
+        params.ode = ode;
+        params.learning_rate = log_uniform(min_learning_rate, max_learning_rate);
+        params.beta1 = uniform(min_beta1, max_beta1);
+        params.beta2 = 1.0 - log_uniform(1.0 - max_beta2, 1.0 - min_beta2);
+        params.epsilon = uniform(min_epsilon, max_epsilon);
+        params.epsilon_decay = uniform(min_epsilon_decay, max_epsilon_decay);
+        return params;
+    }
+};
+
+enum class SearchMethod { Random, SuccessiveHalving, Hyperband };
+
+inline bool parseSearchMethod(const std::string& name, SearchMethod& method) {
+    if (name == "random") method = SearchMethod::Random;
+    else if (name == "halving") method = SearchMethod::SuccessiveHalving;
+    else if (name == "hyperband") method = SearchMethod::Hyperband;
+    else return false;
+    return true;
+}
+
+struct SearchOptions {
+    SearchMethod method = SearchMethod::Hyperband;
+    SearchSpace space;
+    PolicyKind policy = PolicyKind::EpsilonGreedy;
+    int num_trials = 27;               // random search and successive halving
+    int max_epochs = 27;               // R, epochs of a fully trained trial
+    int min_epochs = 1;                // r, first rung
+    int eta = 3;                       // rung reduction factor
+    int threads = 0;                   // 0 = all of the shared ThreadPool
+    size_t epoch_budget = 0;           // trial-epochs for the whole sweep, 0 = unlimited
+    double validation_fraction = 0.2;  // last months held out for scoring
+    size_t shuffle_block = 0;          // EpochOrder block size, 0 = uniform permutation
+    int long_action = 0;
+    uint64_t seed = 0x5eed;
+};
+
+struct TrialResult {
+    int id = 0;
+    Hyperparameters params;
+    int epochs = 0;
+    double score = 0.0;    // last validation score
+    bool stopped = false;  // terminated before max_epochs
+};
+
+struct SearchResult {
+    std::vector<TrialResult> trials;
+    TrialResult best;
+    size_t epochs_used = 0;
+};
+
+// Read-only view shared by every trial: no trial copies or reorders the rows,
+// each one walks its own permutation of train_rows.
+struct SearchDataset {
+    const std::vector<FinancialData>& data;
+    const std::vector<MacroData>& macro;
+    size_t num_symbols;
+    std::vector<size_t> train_rows;
+    std::vector<size_t> validation_rows;  // loader order: by symbol, then date
+    std::vector<size_t> symbol_of_row;
+
+    // train on the first months, validate on the last validation_fraction of them
+    SearchDataset(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+        const PricePanel& panel, double validation_fraction)
+        : SearchDataset(data, macro, panel, 0, static_cast<int>(std::lround(panel.num_periods() * (1.0 - validation_fraction))),
+            static_cast<int>(panel.num_periods())) {}
+
+    // train on periods [train_first, split), validate on [split, validation_last)
+    SearchDataset(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+        const PricePanel& panel, int train_first, int split, int validation_last)
+        : data(data), macro(macro), num_symbols(panel.num_symbols()), symbol_of_row(data.size()) {
+        for (size_t r = 0; r < data.size(); ++r) {
+            symbol_of_row[r] = panel.symbol_index.at(data[r].symbol);
+            int period = data[r].period;
+            if (period >= train_first && period < split) train_rows.push_back(r);
+            else if (period >= split && period < validation_last) validation_rows.push_back(r);
+        }
+    }
+};
+
+// One configuration, trained epoch by epoch so schedulers can pause and resume it.
+// Same on-policy update as the sequential loop in main.
+template <typename Reward>
+class Trial {
+public:
+    TrialResult result;
+
+    Trial(int id, const Hyperparameters& params, const SearchOptions& options, const Reward& reward_fn, size_t num_symbols)
+        : model(params.num_units_macro, params.num_units_accounting, params.num_units_market),
+        adam(params.learning_rate, params.beta1, params.beta2, 1e-8),
+        policy(options.policy, params.epsilon),
+        rewards(num_symbols, reward_fn),
+        series(num_symbols, reward_fn),
+        long_action(options.long_action),
+        shuffle_block(options.shuffle_block),
+        rng(options.seed, static_cast<uint64_t>(id) + 1) {
+        result.id = id;
+        policy.hold_action = long_action;
+        result.params = params;
+        for (LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+            cell->ode_solver_unfolds = params.ode_solver_unfolds;
+            cell->solver = params.solver;
+            cell->adaptive = params.ode;
+        }
+        model.repack();
+        adam.initialize(model.final_layer.weights, model.final_layer.biases);
+    }
+
+    void train_epoch(const SearchDataset& dataset) {
+        // built on the first epoch, a trial always trains on the same dataset
+        if (order.size() != dataset.train_rows.size()) {
+            order = EpochOrder(dataset.train_rows, shuffle_block);
+        }
+        order.shuffle(rng);
+
+        int t = result.epochs + 1;
+        model.encode_months(dataset.macro, macro_outputs);
+        Arena& arena = threadArena();  // trials run on pool workers, one arena each
+        if constexpr (Reward::stateful) {
+            // train_rows are in loader order: stateful rewards see each symbol's months in order
+            series.reset();
+            series.clear();
+            for (size_t row : dataset.train_rows) {
+                ArenaScope step(arena);
+                const FinancialData& fd = dataset.data[row];
+                StepScratch s = model.step_scratch(arena);
+                model.encode(fd, macro_outputs, s.combined_output);
+                model.action_probs(s.combined_output, s.action_probs);
+                series.add(row, dataset.symbol_of_row[row], fd, s.action_probs[long_action]);
+            }
+            series.evaluate();
+        }
+        // windows of the shuffled order: scored, one select_actions call, then updates
+        const size_t width = model.combined_output_size();
+        const size_t A = PortfolioModel::num_actions;
+        for (size_t first = 0; first < order.size(); first += selectionWindow) {
+            const size_t n = std::min(selectionWindow, order.size() - first);
+            ArenaScope step(arena);
+            double* outputs = arena.allocate_array<double>(n * width);
+            double* probs = arena.allocate_array<double>(n * A);
+            int* actions = arena.allocate_array<int>(n);
+            model.score_rows(n, [&](size_t i) -> const FinancialData& {
+                    order.prefetch(dataset.data, first + i);
+                    return dataset.data[order[first + i]];
+                }, macro_outputs, outputs, probs);
+            policy.select_actions(probs, n, A, actions, rng);
+
+            StepScratch s = model.step_scratch(arena);
+            for (size_t i = 0; i < n; ++i) {
+                size_t row = order[first + i];
+                const FinancialData& fd = dataset.data[row];
+                s.combined_output = outputs + i * width;
+                s.action_probs = probs + i * A;
+                double reward = Reward::stateful ? series[row] : rewards[dataset.symbol_of_row[row]](fd, s.action_probs[long_action]);
+                model.policy_update(s, actions[i], reward, adam, t);
+            }
+        }
+        policy.decay_epsilon(result.params.epsilon_decay);
+        result.epochs = t;
+    }
+
+    // expected validation reward of the long action: mean of p_long * reward(p_long)
+    double evaluate(const SearchDataset& dataset) {
+        for (auto& r : rewards) {
+            r.reset();
+        }
+        model.encode_months(dataset.macro, macro_outputs);
+        Arena& arena = threadArena();
+        double total = 0.0;
+        for (size_t row : dataset.validation_rows) {
+            ArenaScope step(arena);
+            const FinancialData& fd = dataset.data[row];
+            StepScratch s = model.step_scratch(arena);
+            model.encode(fd, macro_outputs, s.combined_output);
+            model.action_probs(s.combined_output, s.action_probs);
+            double p = s.action_probs[long_action];
+            total += p * rewards[dataset.symbol_of_row[row]](fd, p);
+        }
+        result.score = dataset.validation_rows.empty() ? 0.0 : total / dataset.validation_rows.size();
+        return result.score;
+    }
+
+private:
+    PortfolioModel model;
+    AdamOptimizer adam;
+    ExplorationPolicy policy;
+    std::vector<Reward> rewards;  // one state per symbol, validation (loader order)
+    DateOrderRewards<Reward> series;  // training rows, scored in date order before each epoch
+    int long_action;
+    size_t shuffle_block;
+    RngStream rng;
+
+    EpochOrder order;
+    std::vector<double> macro_outputs;
+};
+
+// Median stopping rule: a trial whose score after epoch e is below the median of the
+// scores other trials reported after epoch e is terminated.
+class MedianStopper {
+public:
+    MedianStopper(int max_epochs, int min_epochs, size_t min_reports = 3)
+        : reports(max_epochs + 1), min_epochs(min_epochs), min_reports(min_reports) {}
+
+    bool should_stop(int epoch, double score) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<double>& at = reports[epoch];
+        at.push_back(score);
+        if (epoch < min_epochs || at.size() < min_reports) return false;
+        scratch = at;
+        auto middle = scratch.begin() + scratch.size() / 2;
+        std::nth_element(scratch.begin(), middle, scratch.end());
+        return score < *middle;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::vector<double>> reports;  // scores per epoch
+    std::vector<double> scratch;
+    int min_epochs;
+    size_t min_reports;
+};
+
+// Trials run concurrently and share the dataset read-only. The epoch budget is a global
+// counter: a trial that cannot take another epoch stops where it is.
+template <typename Reward>
+class HyperparameterSearch {
+public:
+    HyperparameterSearch(const SearchDataset& dataset, const Reward& reward_fn, const SearchOptions& options)
+        : dataset(dataset), reward_fn(reward_fn), options(options), rng(options.seed, 0) {
+        threads = options.threads > 0 ? options.threads : ThreadPool::instance().concurrency();
+    }
+
+    SearchResult run() {
+        switch (options.method) {
+        case SearchMethod::Random: random_search(options.num_trials); break;
+        case SearchMethod::SuccessiveHalving: successive_halving(options.num_trials, options.min_epochs); break;
+        case SearchMethod::Hyperband:
+        default: hyperband(); break;
+        }
+
+        SearchResult search;
+        search.epochs_used = epochs_used.load();
+        for (const auto& trial : trials) {
+            search.trials.push_back(trial->result);
+            const TrialResult& r = trial->result;
+            if (r.epochs > 0 && (search.best.epochs == 0 || r.score > search.best.score)) {
+                search.best = r;
+            }
+        }
+        search.best.params.epochs = search.best.epochs;
+        return search;
+    }
+
+private:
+    const SearchDataset& dataset;
+    Reward reward_fn;
+    SearchOptions options;
+    RngStream rng;
+    int threads;
+    std::atomic<size_t> epochs_used{ 0 };
+    std::vector<std::unique_ptr<Trial<Reward>>> trials;
+
+    bool take_epoch() {
+        if (options.epoch_budget == 0) {
+            epochs_used.fetch_add(1);
+            return true;
+        }
+        if (epochs_used.fetch_add(1) < options.epoch_budget) return true;
+        epochs_used.fetch_sub(1);
+        return false;
+    }
+
+    std::vector<Trial<Reward>*> new_trials(int count) {
+        std::vector<Trial<Reward>*> created;
+        for (int i = 0; i < count; ++i) {
+            int id = static_cast<int>(trials.size());
+            trials.emplace_back(new Trial<Reward>(id, options.space.sample(rng), options, reward_fn, dataset.num_symbols));
+            created.push_back(trials.back().get());
+        }
+        return created;
+    }
+
+    // every trial to max_epochs, median-stopped
+    void random_search(int count) {
+        std::vector<Trial<Reward>*> batch = new_trials(count);
+        MedianStopper stopper(options.max_epochs, options.min_epochs);
+        parallelFor(batch.size(), threads, [&](size_t i) {
+            Trial<Reward>& trial = *batch[i];
+            while (trial.result.epochs < options.max_epochs) {
+                if (!take_epoch()) {
+                    trial.result.stopped = true;
+                    break;
+                }
+                trial.train_epoch(dataset);
+                if (stopper.should_stop(trial.result.epochs, trial.evaluate(dataset))) {
+                    trial.result.stopped = trial.result.epochs < options.max_epochs;
+                    break;
+                }
+            }
+        });
+    }
+
+    // rungs of first_rung * eta^k epochs, the best 1/eta of each rung is promoted
+    void successive_halving(int count, int first_rung) {
+        std::vector<Trial<Reward>*> alive = new_trials(count);
+        int rung = std::min(first_rung, options.max_epochs);
+        while (!alive.empty()) {
+            parallelFor(alive.size(), threads, [&](size_t i) {
+                Trial<Reward>& trial = *alive[i];
+                bool trained = false;
+                while (trial.result.epochs < rung && take_epoch()) {
+                    trial.train_epoch(dataset);
+                    trained = true;
+                }
+                if (trained) trial.evaluate(dataset);
+                if (trial.result.epochs < rung) trial.result.stopped = true;
+            });
+
+            // budget exhausted mid-rung: nothing can be promoted fairly
+            auto unfinished = std::remove_if(alive.begin(), alive.end(), [](Trial<Reward>* t) { return t->result.stopped; });
+            alive.erase(unfinished, alive.end());
+            if (alive.size() <= 1 || rung >= options.max_epochs) break;
+
+            std::sort(alive.begin(), alive.end(), [](Trial<Reward>* a, Trial<Reward>* b) {
+                return a->result.score > b->result.score;
+            });
+            size_t keep = std::max<size_t>(1, alive.size() / options.eta);
+            for (size_t i = keep; i < alive.size(); ++i) {
+                alive[i]->result.stopped = true;
+            }
+            alive.resize(keep);
+            rung = std::min(options.max_epochs, rung * options.eta);
+        }
+    }
+
+    // brackets from many short trials to few full ones (Li et al.)
+    void hyperband() {
+        const double R = static_cast<double>(options.max_epochs) / std::max(1, options.min_epochs);
+        const int s_max = static_cast<int>(std::floor(std::log(R) / std::log(static_cast<double>(options.eta)) + 1e-9));
+        for (int s = s_max; s >= 0; --s) {
+            double eta_s = std::pow(static_cast<double>(options.eta), s);
+            int count = static_cast<int>(std::ceil((s_max + 1) * eta_s / (s + 1)));
+            int first_rung = std::max(1, static_cast<int>(options.max_epochs / eta_s));
+            successive_halving(count, first_rung);
+        }
+    }
+};
@@ -1,16 +1,20 @@
 //translate to c++ from a paper
+#pragma once
 #include <vector>
 #include <random>
 #include <cmath>
 #include <iostream>
 #include <algorithm>
 #include <numeric>
+#include "Profiler.h"
+#include "AdaptiveODE.h"
 
 enum class MappingType { Identity, Linear, Affine };
-enum class ODESolver { SemiImplicit, Explicit, RungeKutta };
+// Adaptive: error-controlled steps over the same horizon, see AdaptiveODE.h
+enum class ODESolver { SemiImplicit, Explicit, RungeKutta, Adaptive };
 
 
-double sigmoid(double x) {
+inline double sigmoid(double x) {
     return 1.0 / (1.0 + exp(-x));
 }
 
@@ -22,6 +26,8 @@ public:
     int ode_solver_unfolds;
     ODESolver solver;
     MappingType input_mapping;
+    AdaptiveODEConfig adaptive;
+    ODEStats ode_stats;  // ODESolver::Adaptive only
 
     std::vector<std::vector<double>> W, sensory_W, sensory_erev, erev;
     std::vector<double> cm_t, gleak, vleak;
@@ -44,6 +50,11 @@ public:
     }
 
     std::vector<double> ode_step(const std::vector<double>& inputs, const std::vector<double>& state) {
+        PROFILE_SCOPE("LTCCell::ode_step");
+        if (solver == ODESolver::Adaptive) {
+            return ode_step_adaptive(state);
+        }
+        PROFILE_COUNT("ltc.unit_updates", ode_solver_unfolds * num_units);
         std::vector<double> v_pre = state;
         for (int t = 0; t < ode_solver_unfolds; ++t) {
             v_pre = update_state(inputs, v_pre);
@@ -51,12 +62,43 @@ public:
         return v_pre;
     }
 
+    std::vector<double> ode_step_adaptive(const std::vector<double>& state) {
+        std::vector<double> v = state;
+        std::vector<double> activation(num_units), leak(num_units);
+        for (int i = 0; i < num_units; ++i) {
+            leak[i] = gleak[i] * vleak[i];
+        }
+        AdaptiveODEScratch scratch;
+        scratch.resize(num_units);
+        ODEStats call;
+        integrateAdaptive(v.data(), num_units, ode_solver_unfolds, cm_t.data(), gleak.data(), leak.data(), adaptive,
+            [&](const double* x, double* synapse) {
+                for (int j = 0; j < num_units; ++j) {
+                    activation[j] = sigmoid(x[j]);
+                }
+                for (int i = 0; i < num_units; ++i) {
+                    double weighted_sum = 0.0;
+                    for (int j = 0; j < num_units; ++j) {
+                        weighted_sum += W[i][j] * activation[j];
+                    }
+                    synapse[i] = weighted_sum;
+                }
+            }, scratch, call);
+        ode_stats.add(call);
+        PROFILE_COUNT("ltc.unit_updates", call.evaluations * num_units);
+        return v;
+    }
+
     std::vector<double> update_state(const std::vector<double>& inputs, const std::vector<double>& state) {
         std::vector<double> new_state(num_units);
+        std::vector<double> activation(num_units);
+        for (int j = 0; j < num_units; ++j) {
+            activation[j] = sigmoid(state[j]);
+        }
         for (int i = 0; i < num_units; ++i) {
             double weighted_sum = 0.0;
             for (int j = 0; j < num_units; ++j) {
-                weighted_sum += W[i][j] * sigmoid(state[j]);
+                weighted_sum += W[i][j] * activation[j];
             }
             new_state[i] = (cm_t[i] * state[i] + gleak[i] * vleak[i] + weighted_sum) / (cm_t[i] + gleak[i]);
         }
@@ -67,7 +109,63 @@ public:
         return ode_step(inputs, state);
     }
 
+    // ode_step for a [batch x num_units] block of states, updated in place.
+    // Same weights for every row; inputs are not read, like update_state.
+    void ode_step_batch(std::vector<double>& states, size_t batch) {
+        PROFILE_SCOPE("LTCCell::ode_step_batch");
+        if (solver == ODESolver::Adaptive) {
+            ode_step_batch_adaptive(states, batch);
+            return;
+        }
+        PROFILE_COUNT("ltc.unit_updates", ode_solver_unfolds * num_units * batch);
+        std::vector<double> activation(batch * num_units);
+        for (int t = 0; t < ode_solver_unfolds; ++t) {
+            for (size_t k = 0; k < activation.size(); ++k) {
+                activation[k] = sigmoid(states[k]);
+            }
+            for (size_t b = 0; b < batch; ++b) {
+                double* v = &states[b * num_units];
+                const double* act = &activation[b * num_units];
+                for (int i = 0; i < num_units; ++i) {
+                    double weighted_sum = 0.0;
+                    for (int j = 0; j < num_units; ++j) {
+                        weighted_sum += W[i][j] * act[j];
+                    }
+                    v[i] = (cm_t[i] * v[i] + gleak[i] * vleak[i] + weighted_sum) / (cm_t[i] + gleak[i]);
+                }
+            }
+        }
+    }
+
 private:
+    // one integration per row
+    void ode_step_batch_adaptive(std::vector<double>& states, size_t batch) {
+        std::vector<double> activation(num_units), leak(num_units);
+        for (int i = 0; i < num_units; ++i) {
+            leak[i] = gleak[i] * vleak[i];
+        }
+        AdaptiveODEScratch scratch;
+        scratch.resize(num_units);
+        ODEStats call;
+        for (size_t b = 0; b < batch; ++b) {
+            integrateAdaptive(&states[b * num_units], num_units, ode_solver_unfolds, cm_t.data(), gleak.data(), leak.data(),
+                adaptive, [&](const double* x, double* synapse) {
+                    for (int j = 0; j < num_units; ++j) {
+                        activation[j] = sigmoid(x[j]);
+                    }
+                    for (int i = 0; i < num_units; ++i) {
+                        double weighted_sum = 0.0;
+                        for (int j = 0; j < num_units; ++j) {
+                            weighted_sum += W[i][j] * activation[j];
+                        }
+                        synapse[i] = weighted_sum;
+                    }
+                }, scratch, call);
+        }
+        ode_stats.add(call);
+        PROFILE_COUNT("ltc.unit_updates", call.evaluations * num_units);
+    }
+
     std::vector<std::vector<double>> random_matrix(int rows, int cols, double min_val, double max_val) {
         std::vector<std::vector<double>> mat(rows, std::vector<double>(cols));
         std::random_device rd;
@@ -0,0 +1,141 @@
+#include "ModelCompiler.h"
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+// exact: hex float literal
+std::string literal(double x) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", x);
+    return buffer;
+}
+
+void emitArray(std::ostream& out, const std::string& name, const std::vector<double>& values) {
+    out << "constexpr double " << name << "[" << values.size() << "] = {";
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i % 4 == 0 ? "\n    " : " ") << literal(values[i]) << (i + 1 < values.size() ? "," : "");
+    }
+    out << "\n};\n";
+}
+
+// FusedLTCExecutor::step over `cells` as step_<prefix>(state, out): parameters packed the
+// same way, unfolds and sums unrolled
+void emitFusedStep(std::ostream& out, const std::string& prefix, const std::vector<const LTCCell*>& cells) {
+    std::vector<double> W, cm_t, leak, denominator;
+    std::vector<int> offsets, units;
+    std::vector<size_t> weights;
+    int total = 0;
+    for (const LTCCell* cell : cells) {
+        offsets.push_back(total);
+        units.push_back(cell->num_units);
+        weights.push_back(W.size());
+        for (int i = 0; i < cell->num_units; ++i) {
+            W.insert(W.end(), cell->W[i].begin(), cell->W[i].end());
+            cm_t.push_back(cell->cm_t[i]);
+            leak.push_back(cell->gleak[i] * cell->vleak[i]);
+            denominator.push_back(cell->cm_t[i] + cell->gleak[i]);
+        }
+        total += cell->num_units;
+    }
+    const int unfolds = cells.front()->ode_solver_unfolds;
+
+    emitArray(out, prefix + "_W", W);
+    emitArray(out, prefix + "_cm_t", cm_t);
+    emitArray(out, prefix + "_leak", leak);
+    emitArray(out, prefix + "_denominator", denominator);
+    out << "\n// state and out are [" << total << "], " << unfolds << " unfolds\n";
+    out << "inline void step_" << prefix << "(const double* state, double* out) {\n";
+    if (unfolds == 0) {
+        for (int u = 0; u < total; ++u) out << "    out[" << u << "] = state[" << u << "];\n";
+        out << "}\n";
+        return;
+    }
+    out << "    double a[" << total << "];\n";
+    // ping-pong buffers between unfolds, s1 only from the third unfold on
+    if (unfolds > 2) out << "    double s0[" << total << "], s1[" << total << "];\n";
+    else if (unfolds > 1) out << "    double s0[" << total << "];\n";
+    std::string v = "state";
+    for (int t = 0; t < unfolds; ++t) {
+        std::string next = t == unfolds - 1 ? "out" : (t % 2 == 0 ? "s0" : "s1");
+        out << "    // unfold " << t + 1 << "\n";
+        for (int j = 0; j < total; ++j) {
+            out << "    a[" << j << "] = sigmoid(" << v << "[" << j << "]);\n";
+        }
+        for (size_t c = 0; c < cells.size(); ++c) {
+            for (int i = 0; i < units[c]; ++i) {
+                int u = offsets[c] + i;
+                out << "    {\n        double w = 0.0;\n";
+                for (int j = 0; j < units[c]; ++j) {
+                    out << "        w += " << prefix << "_W[" << weights[c] + static_cast<size_t>(i) * units[c] + j
+                        << "] * a[" << offsets[c] + j << "];\n";
+                }
+                out << "        " << next << "[" << u << "] = (" << prefix << "_cm_t[" << u << "] * " << v << "[" << u << "] + "
+                    << prefix << "_leak[" << u << "] + w) / " << prefix << "_denominator[" << u << "];\n    }\n";
+            }
+        }
+        v = next;
+    }
+    out << "}\n";
+}
+
+}
+
+std::string compileModel(const PortfolioModel& model, const std::string& name) {
+    const int macro_units = model.ltc_macro.num_units;
+    const int inputs = model.combined_output_size();
+    const int actions = PortfolioModel::num_actions;
+    const DenseLayer& head = model.final_layer;
+
+    std::ostringstream out;
+    out << "// Generated by compile_model: PortfolioModel with " << macro_units << "/" << model.ltc_accounting.num_units
+        << "/" << model.ltc_market.num_units << " units, " << model.ltc_macro.ode_solver_unfolds << " unfolds.\n"
+        << "// Do not edit. Build without -ffast-math to keep the scores bit-identical to the engine.\n"
+        << "#pragma once\n#include <cmath>\n\nnamespace " << name << " {\n\n"
+        << "constexpr int macro_units = " << macro_units << ";\n"
+        << "constexpr int combined_output_size = " << inputs << ";\n"
+        << "constexpr int num_actions = " << actions << ";\n\n"
+        << "inline double sigmoid(double x) {\n    return 1.0 / (1.0 + std::exp(-x));\n}\n\n";
+
+    emitFusedStep(out, "macro", { &model.ltc_macro });
+    out << "\n";
+    emitFusedStep(out, "rest", { &model.ltc_accounting, &model.ltc_market });
+    out << "\n";
+    emitArray(out, "state_macro", model.state_macro);
+    emitArray(out, "initial_rest", concat(model.state_accounting, model.state_market));
+    std::vector<double> head_W;
+    for (const auto& row : head.weights) head_W.insert(head_W.end(), row.begin(), row.end());
+    emitArray(out, "head_W", head_W);
+    emitArray(out, "head_b", head.biases);
+
+    out << "\n// macro LTC from the saved macro state: one month of PortfolioModel::encode_months\n"
+        << "inline void encode_month(double* macro_output) {\n    step_macro(state_macro, macro_output);\n}\n\n";
+
+    out << "// PortfolioModel::encode + action_probs of a row with its month's macro output\n"
+        << "inline void score(const double* macro_output, double* probs) {\n"
+        << "    double x[" << inputs << "];\n";
+    for (int j = 0; j < macro_units; ++j) {
+        out << "    x[" << j << "] = macro_output[" << j << "];\n";
+    }
+    out << "    step_rest(initial_rest, x + " << macro_units << ");\n";
+    for (int i = 0; i < actions; ++i) {
+        out << "    double l" << i << " = 0.0;\n";
+        for (int j = 0; j < inputs; ++j) {
+            out << "    l" << i << " += x[" << j << "] * head_W[" << i * inputs + j << "];\n";
+        }
+        out << "    l" << i << " += head_b[" << i << "];\n";
+    }
+    out << "    double m = l0;\n";
+    for (int i = 1; i < actions; ++i) {
+        out << "    if (m < l" << i << ") m = l" << i << ";\n";
+    }
+    out << "    double sum = 0.0;\n";
+    for (int i = 0; i < actions; ++i) {
+        out << "    probs[" << i << "] = std::exp(l" << i << " - m);\n    sum += probs[" << i << "];\n";
+    }
+    for (int i = 0; i < actions; ++i) {
+        out << "    probs[" << i << "] /= sum;\n";
+    }
+    out << "}\n\n}\n";
+    return out.str();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include "PortfolioModel.h"
+
+// Ahead-of-time compiler for a trained PortfolioModel: emits a standalone header (only
+// <cmath>) with the parameters as constexpr arrays (hex float literals, exact) and the ODE
+// unfolds, synapse sums and head fully unrolled for the model's shapes. Every operation
+// keeps the order of FusedLTCExecutor::step, DenseLayer::forward and softmax, so built
+// without -ffast-math / FP contraction the generated scorer matches the engine bit for bit.
+// Fixed unfolds only: compile_model refuses models trained with ODESolver::Adaptive.
+//
+//   namespace <name> {
+//   // macro LTC from the saved macro state: one month of PortfolioModel::encode_months
+//   void encode_month(double* macro_output);
+//   // PortfolioModel::encode + action_probs of a row with that month's macro output
+//   void score(const double* macro_output, double* probs);
+//   }
+std::string compileModel(const PortfolioModel& model, const std::string& name);
@@ -0,0 +1,118 @@
+#include "ModelFile.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+void writeVector(std::ostream& file, const std::vector<double>& v) {
+    file.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(double));
+}
+
+void writeMatrix(std::ostream& file, const std::vector<std::vector<double>>& m) {
+    for (const auto& row : m) writeVector(file, row);
+}
+
+bool readVector(std::istream& file, std::vector<double>& v) {
+    file.read(reinterpret_cast<char*>(v.data()), v.size() * sizeof(double));
+    return static_cast<bool>(file);
+}
+
+bool readMatrix(std::istream& file, std::vector<std::vector<double>>& m) {
+    for (auto& row : m) {
+        if (!readVector(file, row)) return false;
+    }
+    return true;
+}
+
+void writeCell(std::ostream& file, const LTCCell& cell) {
+    writeMatrix(file, cell.W);
+    writeMatrix(file, cell.sensory_W);
+    writeMatrix(file, cell.erev);
+    writeMatrix(file, cell.sensory_erev);
+    writeVector(file, cell.cm_t);
+    writeVector(file, cell.gleak);
+    writeVector(file, cell.vleak);
+}
+
+bool readCell(std::istream& file, LTCCell& cell) {
+    return readMatrix(file, cell.W) && readMatrix(file, cell.sensory_W) && readMatrix(file, cell.erev)
+        && readMatrix(file, cell.sensory_erev) && readVector(file, cell.cm_t) && readVector(file, cell.gleak)
+        && readVector(file, cell.vleak);
+}
+
+}
+
+bool writeModel(std::ostream& file, const PortfolioModel& model) {
+    ModelFileHeader header{};
+    std::memcpy(header.magic, modelFileMagic, sizeof(header.magic));
+    header.version = modelFileVersion;
+    header.units_macro = model.ltc_macro.num_units;
+    header.units_accounting = model.ltc_accounting.num_units;
+    header.units_market = model.ltc_market.num_units;
+    header.ode_solver_unfolds = model.ltc_macro.ode_solver_unfolds;
+    header.num_actions = PortfolioModel::num_actions;
+    header.ode_solver = static_cast<int32_t>(model.ltc_macro.solver);
+    header.adaptive = model.ltc_macro.adaptive;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+        writeCell(file, *cell);
+    }
+    writeVector(file, model.state_macro);
+    writeVector(file, model.state_accounting);
+    writeVector(file, model.state_market);
+    writeMatrix(file, model.final_layer.weights);
+    writeVector(file, model.final_layer.biases);
+    return static_cast<bool>(file);
+}
+
+bool readModel(std::istream& file, PortfolioModel& model, const std::string& source) {
+    ModelFileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, modelFileMagic, sizeof(header.magic)) != 0
+        || header.version != modelFileVersion || header.num_actions != PortfolioModel::num_actions
+        || header.units_macro <= 0 || header.units_accounting <= 0 || header.units_market <= 0
+        || header.ode_solver_unfolds < 0 || header.ode_solver < 0
+        || header.ode_solver > static_cast<int32_t>(ODESolver::Adaptive)) {
+        std::cerr << "Not a model file (or another version): " << source << std::endl;
+        return false;
+    }
+
+    PortfolioModel loaded(header.units_macro, header.units_accounting, header.units_market);
+    bool ok = true;
+    for (LTCCell* cell : { &loaded.ltc_macro, &loaded.ltc_accounting, &loaded.ltc_market }) {
+        cell->ode_solver_unfolds = header.ode_solver_unfolds;
+        cell->solver = static_cast<ODESolver>(header.ode_solver);
+        cell->adaptive = header.adaptive;
+        ok = ok && readCell(file, *cell);
+    }
+    ok = ok && readVector(file, loaded.state_macro) && readVector(file, loaded.state_accounting)
+        && readVector(file, loaded.state_market) && readMatrix(file, loaded.final_layer.weights)
+        && readVector(file, loaded.final_layer.biases);
+    if (!ok) {
+        std::cerr << "Truncated model file: " << source << std::endl;
+        return false;
+    }
+    loaded.repack();
+    model = loaded;
+    return true;
+}
+
+bool saveModel(const std::string& path, const PortfolioModel& model) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Cannot write model file: " << path << std::endl;
+        return false;
+    }
+    return writeModel(file, model);
+}
+
+bool loadModel(const std::string& path, PortfolioModel& model) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open model file: " << path << std::endl;
+        return false;
+    }
+    return readModel(file, model, path);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include "PortfolioModel.h"
+
+// Trained PortfolioModel on disk: a fixed header with the shapes and the ODE solver, then native-endian doubles
+// (per cell W, sensory_W, erev, sensory_erev, cm_t, gleak, vleak; the three states; the head
+// weights row by row and its biases). Written by portfolio --save-model=..., read by
+// compile_model; distributed training sends the same bytes to give every rank one model.
+struct ModelFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t units_macro;
+    int32_t units_accounting;
+    int32_t units_market;
+    int32_t ode_solver_unfolds;
+    int32_t num_actions;
+    int32_t ode_solver;          // ODESolver
+    AdaptiveODEConfig adaptive;  // read when ode_solver is ODESolver::Adaptive
+};
+
+constexpr char modelFileMagic[8] = { 'P', 'F', 'M', 'O', 'D', 'E', 'L', 1 };
+constexpr uint32_t modelFileVersion = 2;  // 2: ode_solver, adaptive
+
+bool writeModel(std::ostream& file, const PortfolioModel& model);
+// source names the stream in error messages
+bool readModel(std::istream& file, PortfolioModel& model, const std::string& source);
+
+bool saveModel(const std::string& path, const PortfolioModel& model);
+// replaces model (shapes come from the file), repacked and ready to encode
+bool loadModel(const std::string& path, PortfolioModel& model);
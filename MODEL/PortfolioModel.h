@@ -0,0 +1,198 @@
+#pragma once
+#include "LTC.h"
+#include "FusedLTC.h"
+#include "DenseLayer.h"
+#include "FinancialData.h"
+#include "FeatureSchema.h"
+#include "AdamOptimizer.h"
+#include "Arena.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+inline std::vector<double> concat(const std::vector<double>& v1, const std::vector<double>& v2) {
+    std::vector<double> result = v1;
+    result.insert(result.end(), v2.begin(), v2.end());
+    return result;
+}
+
+// probs may alias logits
+inline void softmax(const double* logits, size_t n, double* probs) {
+    double max_logit = *std::max_element(logits, logits + n);
+    double sum_exp = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        probs[i] = std::exp(logits[i] - max_logit); // stabilisation
+        sum_exp += probs[i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        probs[i] /= sum_exp;
+    }
+}
+
+inline std::vector<double> softmax(const std::vector<double>& logits) {
+    std::vector<double> exp_logits(logits.size());
+    softmax(logits.data(), logits.size(), exp_logits.data());
+    return exp_logits;
+}
+
+// d(-advantage * log p[action]) / d logits
+inline void policyGradient(const double* action_probs, size_t n, int action, double advantage, double* grad_output) {
+    for (size_t i = 0; i < n; ++i) {
+        if (i == static_cast<size_t>(action)) {
+            grad_output[i] = -advantage * (1 - action_probs[i]);
+        }
+        else {
+            grad_output[i] = advantage * action_probs[i];
+        }
+    }
+}
+
+inline std::vector<double> policyGradient(const std::vector<double>& action_probs, int action, double advantage) {
+    std::vector<double> grad_output(action_probs.size(), 0.0);
+    policyGradient(action_probs.data(), action_probs.size(), action, advantage, grad_output.data());
+    return grad_output;
+}
+
+// Temporaries of one on-policy step, bump-allocated from an arena that the caller rewinds
+// after the step (ArenaScope); nothing in the row loop reaches malloc.
+struct StepScratch {
+    double* combined_output;  // [combined_output_size]
+    double* action_probs;     // [num_actions]
+    double* grad_output;      // [num_actions]
+    double* dW;               // [num_actions x combined_output_size]
+    double* dB;               // [num_actions]
+};
+
+// macro / accounting / market LTC sub-networks feeding one dense head
+class PortfolioModel {
+public:
+    static constexpr int input_size_macro = featureCount(FeatureGroup::Macro);            // nb input macro
+    static constexpr int input_size_accounting = featureCount(FeatureGroup::Accounting);  // nb accounting inputs
+    static constexpr int input_size_market = featureCount(FeatureGroup::Market);          // nb markets inputs
+    static const int num_actions = 2;
+
+    LTCCell ltc_macro;
+    LTCCell ltc_accounting;
+    LTCCell ltc_market;
+
+    std::vector<double> state_macro;
+    std::vector<double> state_accounting;
+    std::vector<double> state_market;
+
+    DenseLayer final_layer;
+
+    // macro alone (run once per month) and accounting + market packed block-diagonally,
+    // repack() after changing LTC parameters
+    FusedLTCExecutor fused_macro;
+    FusedLTCExecutor fused;
+
+    PortfolioModel(int num_units_macro, int num_units_accounting, int num_units_market)
+        : ltc_macro(num_units_macro, input_size_macro),
+        ltc_accounting(num_units_accounting, input_size_accounting),
+        ltc_market(num_units_market, input_size_market),
+        state_macro(num_units_macro, 0.0),
+        state_accounting(num_units_accounting, 0.0),
+        state_market(num_units_market, 0.0),
+        final_layer(num_units_macro + num_units_accounting + num_units_market, num_actions) {
+        repack();
+    }
+
+    void repack() {
+        fused_macro.pack({ &ltc_macro });
+        fused.pack({ &ltc_accounting, &ltc_market });
+        initial_rest = concat(state_accounting, state_market);
+    }
+
+    int combined_output_size() const { return final_layer.input_size; }
+
+    // ODESolver::Adaptive work of both executors since the last call
+    ODEStats take_ode_stats() {
+        ODEStats stats = fused_macro.ode_stats;
+        stats.add(fused.ode_stats);
+        fused_macro.ode_stats = fused.ode_stats = ODEStats();
+        return stats;
+    }
+
+    std::vector<double> combined_state() const {
+        return concat(concat(state_macro, state_accounting), state_market);
+    }
+
+    // macro LTC once per month, macro_outputs is [months x num_units_macro]
+    void encode_months(const std::vector<MacroData>& macro, std::vector<double>& macro_outputs) {
+        const size_t units = ltc_macro.num_units;
+        macro_outputs.resize(macro.size() * units);
+        for (size_t t = 0; t < macro.size(); ++t) {
+            fused_macro.step(state_macro.data(), &macro_outputs[t * units]);
+        }
+    }
+
+    // LTC trio for one row in concat order: the month's macro output is broadcast into
+    // the first block, accounting and market are stepped straight into combined_output
+    // (the cells do not read their sensory inputs, only their states)
+    void encode(const FinancialData& fd, const std::vector<double>& macro_outputs, std::vector<double>& combined_output) {
+        combined_output.resize(combined_output_size());
+        encode(fd, macro_outputs, combined_output.data());
+    }
+
+    void encode(const FinancialData& fd, const std::vector<double>& macro_outputs, double* combined_output) {
+        const size_t units = ltc_macro.num_units;
+        std::copy_n(&macro_outputs[fd.period * units], units, combined_output);
+        fused.step(initial_rest.data(), combined_output + units);
+    }
+
+    std::vector<double> encode(const FinancialData& fd, const std::vector<double>& macro_outputs) {
+        std::vector<double> combined_output(combined_output_size());
+        encode(fd, macro_outputs, combined_output);
+        return combined_output;
+    }
+
+    std::vector<double> action_probs(const std::vector<double>& combined_output) const {
+        return softmax(final_layer.forward(combined_output));
+    }
+
+    void action_probs(const double* combined_output, double* probs) const {
+        final_layer.forward(combined_output, probs);
+        softmax(probs, num_actions, probs);
+    }
+
+    // encode + action_probs of n rows, row(i) the i-th FinancialData: outputs is
+    // [n x combined_output_size], probs [n x num_actions]
+    template <typename Row>
+    void score_rows(size_t n, Row&& row, const std::vector<double>& macro_outputs, double* outputs, double* probs) {
+        const size_t width = combined_output_size();
+        for (size_t i = 0; i < n; ++i) {
+            encode(row(i), macro_outputs, outputs + i * width);
+            action_probs(outputs + i * width, probs + i * num_actions);
+        }
+    }
+
+    StepScratch step_scratch(Arena& arena) const {
+        const size_t n = combined_output_size();
+        StepScratch s;
+        s.combined_output = arena.allocate_array<double>(n);
+        s.action_probs = arena.allocate_array<double>(num_actions);
+        s.grad_output = arena.allocate_array<double>(num_actions);
+        s.dW = arena.allocate_array<double>(num_actions * n);
+        s.dB = arena.allocate_array<double>(num_actions);
+        return s;
+    }
+
+    // REINFORCE update of the head for the action taken in s (encode + action_probs done)
+    void policy_update(const StepScratch& s, int action, double advantage, AdamOptimizer& adam, int t) {
+        policyGradient(s.action_probs, num_actions, action, advantage, s.grad_output);
+        final_layer.backward(s.combined_output, s.grad_output, s.dW, s.dB);
+        adam.update(final_layer.weights, final_layer.biases, s.dW, s.dB, t);
+    }
+
+    // policy_update's gradient added to dW_sum / dB_sum instead of applied (minibatches)
+    void accumulate_policy_gradient(const StepScratch& s, int action, double advantage, double* dW_sum, double* dB_sum) const {
+        policyGradient(s.action_probs, num_actions, action, advantage, s.grad_output);
+        final_layer.backward(s.combined_output, s.grad_output, s.dW, s.dB);
+        const size_t n = static_cast<size_t>(num_actions) * combined_output_size();
+        for (size_t k = 0; k < n; ++k) dW_sum[k] += s.dW[k];
+        for (int i = 0; i < num_actions; ++i) dB_sum[i] += s.dB[i];
+    }
+
+private:
+    std::vector<double> initial_rest;
+};
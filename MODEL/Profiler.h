@@ -0,0 +1,202 @@
+#pragma once
+// Scoped timers and counters for the hot paths. Everything compiles to nothing unless
+// PORTFOLIO_PROFILE is defined (-DPORTFOLIO_PROFILE).
+//
+//   PROFILE_SCOPE("DenseLayer::forward");   time the rest of the enclosing block
+//   PROFILE_COUNT("rows", n);               add n to a counter
+//   PROFILE_SUMMARY(std::cout, "Epoch 3");  totals since the previous summary
+//   PROFILE_WRITE_TRACE("trace.json");      Chrome trace (chrome://tracing, Perfetto)
+
+#ifdef PORTFOLIO_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace profiler {
+
+constexpr int max_sites = 128;
+constexpr size_t max_trace_events = 1 << 20;  // per thread, later events are only counted
+
+inline uint64_t now_ns() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+struct TraceEvent {
+    int site;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// One per thread, written only by its owner: no contention on the hot path. The
+// totals are relaxed atomics so a summary can read them while workers run.
+struct ThreadProfile {
+    int tid = 0;
+    std::atomic<uint64_t> calls[max_sites] = {};
+    std::atomic<uint64_t> total_ns[max_sites] = {};  // counters: summed values
+    std::vector<TraceEvent> trace;                   // read only by write_chrome_trace
+    size_t dropped = 0;
+
+    void add(int site, uint64_t calls_delta, uint64_t value) {
+        calls[site].store(calls[site].load(std::memory_order_relaxed) + calls_delta, std::memory_order_relaxed);
+        total_ns[site].store(total_ns[site].load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void record(int site, uint64_t start, uint64_t duration) {
+        if (trace.size() < max_trace_events) trace.push_back({ site, start, duration });
+        else ++dropped;
+    }
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    // called once per call site (function-local static), same name = same entry
+    int site(const char* name, bool counter) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < num_sites; ++i) {
+            if (std::strcmp(sites[i].name, name) == 0) return i;
+        }
+        if (num_sites == max_sites) return max_sites - 1;
+        sites[num_sites] = { name, counter };
+        return num_sites++;
+    }
+
+    ThreadProfile& thread() {
+        thread_local ThreadProfile* profile = register_thread();
+        return *profile;
+    }
+
+    // per-site totals since the previous summary, merged over threads
+    void summary(std::ostream& out, const std::string& label) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t now = now_ns();
+        double wall_ms = (now - last_summary_ns) / 1e6;
+        last_summary_ns = now;
+
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << "Profile [" << label << "] wall " << std::fixed << std::setprecision(2) << wall_ms << " ms" << std::endl;
+        for (int s = 0; s < num_sites; ++s) {
+            uint64_t calls = 0, total = 0;
+            for (const auto& profile : threads) {
+                calls += profile.calls[s].load(std::memory_order_relaxed);
+                total += profile.total_ns[s].load(std::memory_order_relaxed);
+            }
+            uint64_t d_calls = calls - reported_calls[s];
+            uint64_t d_total = total - reported_total[s];
+            reported_calls[s] = calls;
+            reported_total[s] = total;
+            if (d_calls == 0) continue;
+
+            out << "  " << std::left << std::setw(32) << sites[s].name << std::right << std::setw(12) << d_calls;
+            if (sites[s].counter) {
+                out << std::setw(16) << d_total << " total" << std::endl;
+            }
+            else {
+                double ms = d_total / 1e6;
+                out << std::setw(12) << ms << " ms" << std::setw(12) << (d_total / 1e3) / d_calls << " us/call"
+                    << std::setw(8) << (wall_ms > 0.0 ? 100.0 * ms / wall_ms : 0.0) << " %" << std::endl;
+            }
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // complete ("X") events in the Trace Event Format; call once worker threads are joined
+    bool write_chrome_trace(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        file << "{\"traceEvents\":[";
+        bool first = true;
+        size_t dropped = 0;
+        for (const auto& profile : threads) {
+            for (const TraceEvent& e : profile.trace) {
+                file << (first ? "\n" : ",\n") << "{\"name\":\"" << sites[e.site].name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << profile.tid << ",\"ts\":" << e.start_ns / 1000.0 << ",\"dur\":" << e.duration_ns / 1000.0 << "}";
+                first = false;
+            }
+            dropped += profile.dropped;
+        }
+        file << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+        return true;
+    }
+
+private:
+    struct Site {
+        const char* name;
+        bool counter;
+    };
+
+    std::mutex mutex;
+    Site sites[max_sites] = {};
+    int num_sites = 0;
+    std::deque<ThreadProfile> threads;  // stable addresses, outlive their threads
+    uint64_t reported_calls[max_sites] = {};
+    uint64_t reported_total[max_sites] = {};
+    uint64_t last_summary_ns = now_ns();
+
+    ThreadProfile* register_thread() {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.emplace_back();
+        threads.back().tid = static_cast<int>(threads.size());
+        return &threads.back();
+    }
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int site) : site(site), profile(Registry::instance().thread()), start(now_ns()) {}
+
+    ~ScopedTimer() {
+        uint64_t duration = now_ns() - start;
+        profile.add(site, 1, duration);
+        profile.record(site, start, duration);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int site;
+    ThreadProfile& profile;
+    uint64_t start;
+};
+
+} // namespace profiler
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profile_site_, __LINE__) = ::profiler::Registry::instance().site(name, false); \
+    ::profiler::ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(PROFILE_CONCAT(profile_site_, __LINE__))
+#define PROFILE_COUNT(name, n) \
+    do { \
+        static const int profile_site_ = ::profiler::Registry::instance().site(name, true); \
+        ::profiler::Registry::instance().thread().add(profile_site_, 1, static_cast<uint64_t>(n)); \
+    } while (0)
+#define PROFILE_SUMMARY(out, label) ::profiler::Registry::instance().summary(out, label)
+#define PROFILE_WRITE_TRACE(path) ::profiler::Registry::instance().write_chrome_trace(path)
+
+#else
+
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_COUNT(name, n) do {} while (0)
+#define PROFILE_SUMMARY(out, label) do {} while (0)
+#define PROFILE_WRITE_TRACE(path) do {} while (0)
+
+#endif
@@ -0,0 +1,310 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include "PortfolioModel.h"
+
+// Post-training int8 inference for scoring: LTC synapse matrices and the dense head are
+// quantized to int8 with one scale per row, activations to 8 bits, dot products accumulate
+// in int32. Training stays fp64; build a QuantizedPortfolioModel from the trained model,
+// calibrate it on held-out rows and check it with compareQuantized.
+
+// int8 x 8-bit dot product with 32-bit accumulation. A plain loop: with
+// -DPORTFOLIO_NATIVE=ON compilers turn it into vpmaddwd (AVX2) or vpdpbusd (AVX-512 VNNI).
+template <typename X>
+inline int32_t dotInt8(const int8_t* w, const X* x, int n) {
+    int32_t sum = 0;
+    for (int j = 0; j < n; ++j) {
+        sum += static_cast<int32_t>(w[j]) * static_cast<int32_t>(x[j]);
+    }
+    return sum;
+}
+
+inline int8_t quantizeInt8(double x) {
+    return static_cast<int8_t>(std::lround(std::min(127.0, std::max(-127.0, x))));
+}
+
+// sigmoid(v) * 255 rounded, from a table over [-range, range] (saturated outside). The
+// table step moves sigmoid by less than half a quantization step.
+class SigmoidTable {
+public:
+    static constexpr int size = 4096;
+    static constexpr double range = 8.0;
+
+    SigmoidTable() {
+        for (int i = 0; i < size; ++i) {
+            double v = -range + 2.0 * range * i / (size - 1);
+            table[i] = static_cast<uint8_t>(std::lround(255.0 * sigmoid(v)));
+        }
+    }
+
+    uint8_t operator()(double v) const {
+        double x = (v + range) * ((size - 1) / (2.0 * range)) + 0.5;
+        return table[static_cast<int>(std::min(std::max(x, 0.0), size - 1.0))];
+    }
+
+    static const SigmoidTable& instance() {
+        static const SigmoidTable table;
+        return table;
+    }
+
+private:
+    uint8_t table[size];
+};
+
+// row-major int8 matrix, W[i][j] ~ scales[i] * values[i * cols + j]
+struct QuantizedMatrix {
+    int rows = 0;
+    int cols = 0;
+    std::vector<int8_t> values;
+    std::vector<double> scales;
+
+    // w is row-major [rows x cols]; a row's largest magnitude maps to 127
+    void quantize(const double* w, int rows, int cols) {
+        this->rows = rows;
+        this->cols = cols;
+        values.resize(static_cast<size_t>(rows) * cols);
+        scales.resize(rows);
+        for (int i = 0; i < rows; ++i) {
+            const double* row = w + static_cast<size_t>(i) * cols;
+            double max_abs = 0.0;
+            for (int j = 0; j < cols; ++j) max_abs = std::max(max_abs, std::fabs(row[j]));
+            scales[i] = max_abs > 0.0 ? max_abs / 127.0 : 1.0;
+            for (int j = 0; j < cols; ++j) {
+                values[static_cast<size_t>(i) * cols + j] = quantizeInt8(row[j] / scales[i]);
+            }
+        }
+    }
+
+    const int8_t* row(int i) const { return &values[static_cast<size_t>(i) * cols]; }
+};
+
+// FusedLTCExecutor with int8 W and table sigmoid activations (8-bit, scale 1/255); states
+// and the leak terms stay fp64. Fixed unfolds only, main rejects --quantize with --ode=adaptive.
+class QuantizedLTC {
+public:
+    int total_units = 0;
+    int ode_solver_unfolds = 6;
+
+    void pack(const std::vector<const LTCCell*>& cells) {
+        total_units = 0;
+        blocks.clear();
+        cm_t.clear();
+        leak.clear();
+        denominator.clear();
+        for (const LTCCell* cell : cells) {
+            Block block;
+            block.offset = total_units;
+            std::vector<double> w;
+            for (int i = 0; i < cell->num_units; ++i) {
+                w.insert(w.end(), cell->W[i].begin(), cell->W[i].end());
+                cm_t.push_back(cell->cm_t[i]);
+                leak.push_back(cell->gleak[i] * cell->vleak[i]);
+                denominator.push_back(cell->cm_t[i] + cell->gleak[i]);
+            }
+            block.W.quantize(w.data(), cell->num_units, cell->num_units);
+            for (double& s : block.W.scales) s /= 255.0;  // folds the activation scale in
+            blocks.push_back(std::move(block));
+            total_units += cell->num_units;
+            ode_solver_unfolds = cell->ode_solver_unfolds;
+        }
+        activation.resize(total_units);
+        scratch.resize(total_units);
+    }
+
+    // state and out are [total_units], in concat order; they may alias
+    void step(const double* state, double* out) {
+        PROFILE_SCOPE("QuantizedLTC::step");
+        const SigmoidTable& sigmoid_table = SigmoidTable::instance();
+        const double* v = state;
+        for (int t = 0; t < ode_solver_unfolds; ++t) {
+            for (int j = 0; j < total_units; ++j) {
+                activation[j] = sigmoid_table(v[j]);
+            }
+            double* next = (t == ode_solver_unfolds - 1) ? out : scratch.data();
+            for (const Block& block : blocks) {
+                const uint8_t* act = &activation[block.offset];
+                for (int i = 0; i < block.W.rows; ++i) {
+                    double weighted_sum = block.W.scales[i] * dotInt8(block.W.row(i), act, block.W.cols);
+                    int u = block.offset + i;
+                    next[u] = (cm_t[u] * v[u] + leak[u] + weighted_sum) / denominator[u];
+                }
+            }
+            v = next;
+        }
+        if (ode_solver_unfolds == 0 && out != state) {
+            std::copy(state, state + total_units, out);
+        }
+    }
+
+private:
+    struct Block {
+        int offset;  // first unit in the fused state
+        QuantizedMatrix W;
+    };
+
+    std::vector<Block> blocks;
+    std::vector<double> cm_t, leak, denominator;
+    std::vector<uint8_t> activation;
+    std::vector<double> scratch;
+};
+
+// DenseLayer with int8 weights and int8 inputs. Inputs are quantized per column with the
+// range seen during calibration; the column scales are folded into the weights before their
+// per-row quantization, so the kernel is one int8 dot product per output.
+class QuantizedDense {
+public:
+    int input_size = 0;
+    int output_size = 0;
+
+    // input_range[j] = largest |input j| expected (calibration)
+    void quantize(const DenseLayer& layer, const std::vector<double>& input_range) {
+        input_size = layer.input_size;
+        output_size = layer.output_size;
+        inv_input_scale.resize(input_size);
+        std::vector<double> w(static_cast<size_t>(output_size) * input_size);
+        for (int j = 0; j < input_size; ++j) {
+            double scale = input_range[j] > 0.0 ? input_range[j] / 127.0 : 1.0;
+            inv_input_scale[j] = 1.0 / scale;
+            for (int i = 0; i < output_size; ++i) {
+                w[static_cast<size_t>(i) * input_size + j] = layer.weights[i][j] * scale;
+            }
+        }
+        W.quantize(w.data(), output_size, input_size);
+        biases = layer.biases;
+        input.resize(input_size);
+    }
+
+    void forward(const double* x, double* output) {
+        for (int j = 0; j < input_size; ++j) {
+            input[j] = quantizeInt8(x[j] * inv_input_scale[j]);
+        }
+        for (int i = 0; i < output_size; ++i) {
+            output[i] = W.scales[i] * dotInt8(W.row(i), input.data(), input_size) + biases[i];
+        }
+    }
+
+private:
+    QuantizedMatrix W;
+    std::vector<double> inv_input_scale;
+    std::vector<double> biases;
+    std::vector<int8_t> input;
+};
+
+// int8 twin of a trained PortfolioModel (same encode / action_probs contract)
+class QuantizedPortfolioModel {
+public:
+    // the head is usable after calibrate()
+    explicit QuantizedPortfolioModel(const PortfolioModel& model)
+        : macro_units(model.ltc_macro.num_units),
+        state_macro(model.state_macro),
+        initial_rest(concat(model.state_accounting, model.state_market)) {
+        ltc_macro.pack({ &model.ltc_macro });
+        ltc_rest.pack({ &model.ltc_accounting, &model.ltc_market });
+        head_range.assign(model.combined_output_size(), 0.0);
+        head.quantize(model.final_layer, head_range);
+    }
+
+    // input ranges of the head from the fp64 model's combined outputs on `rows`
+    void calibrate(const PortfolioModel& model, const std::vector<FinancialData>& data,
+        const std::vector<MacroData>& macro, const std::vector<size_t>& rows) {
+        PortfolioModel reference = model;  // encode_months is not const
+        std::vector<double> macro_outputs;
+        std::vector<double> combined_output(model.combined_output_size());
+        reference.encode_months(macro, macro_outputs);
+        std::fill(head_range.begin(), head_range.end(), 0.0);
+        for (size_t r : rows) {
+            reference.encode(data[r], macro_outputs, combined_output.data());
+            for (size_t j = 0; j < combined_output.size(); ++j) {
+                head_range[j] = std::max(head_range[j], std::fabs(combined_output[j]));
+            }
+        }
+        head.quantize(model.final_layer, head_range);
+    }
+
+    void encode_months(const std::vector<MacroData>& macro, std::vector<double>& macro_outputs) {
+        macro_outputs.resize(macro.size() * macro_units);
+        for (size_t t = 0; t < macro.size(); ++t) {
+            ltc_macro.step(state_macro.data(), &macro_outputs[t * macro_units]);
+        }
+    }
+
+    void encode(const FinancialData& fd, const std::vector<double>& macro_outputs, double* combined_output) {
+        std::copy_n(&macro_outputs[fd.period * macro_units], macro_units, combined_output);
+        ltc_rest.step(initial_rest.data(), combined_output + macro_units);
+    }
+
+    void action_probs(const double* combined_output, double* probs) {
+        head.forward(combined_output, probs);
+        softmax(probs, PortfolioModel::num_actions, probs);
+    }
+
+private:
+    size_t macro_units;
+    std::vector<double> state_macro;
+    std::vector<double> initial_rest;
+    QuantizedLTC ltc_macro;
+    QuantizedLTC ltc_rest;
+    QuantizedDense head;
+    std::vector<double> head_range;
+};
+
+struct QuantizationReport {
+    size_t rows = 0;
+    double max_prob_error = 0.0;   // largest |p_int8 - p_fp64| over actions and rows
+    double mean_prob_error = 0.0;
+    double action_agreement = 0.0;  // share of rows with the same most likely action
+    double fp64_rows_per_second = 0.0;
+    double int8_rows_per_second = 0.0;
+};
+
+// scores `rows` with both models from the same starting macro state
+inline QuantizationReport compareQuantized(const PortfolioModel& model, const QuantizedPortfolioModel& quantized,
+    const std::vector<FinancialData>& data, const std::vector<MacroData>& macro, const std::vector<size_t>& rows) {
+    QuantizationReport report;
+    report.rows = rows.size();
+    if (rows.empty()) return report;
+    const int A = PortfolioModel::num_actions;
+    const size_t n = model.combined_output_size();
+    std::vector<double> macro_outputs, combined_output(n), reference_probs(rows.size() * A), int8_probs(rows.size() * A);
+
+    // both timed regions only score into a buffer, the comparison runs after them
+    PortfolioModel reference = model;
+    auto start = std::chrono::steady_clock::now();
+    reference.encode_months(macro, macro_outputs);
+    for (size_t k = 0; k < rows.size(); ++k) {
+        reference.encode(data[rows[k]], macro_outputs, combined_output.data());
+        reference.action_probs(combined_output.data(), &reference_probs[k * A]);
+    }
+    double fp64_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    QuantizedPortfolioModel q = quantized;
+    start = std::chrono::steady_clock::now();
+    q.encode_months(macro, macro_outputs);
+    for (size_t k = 0; k < rows.size(); ++k) {
+        q.encode(data[rows[k]], macro_outputs, combined_output.data());
+        q.action_probs(combined_output.data(), &int8_probs[k * A]);
+    }
+    double int8_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t agree = 0;
+    double total_error = 0.0;
+    for (size_t k = 0; k < rows.size(); ++k) {
+        const double* probs = &int8_probs[k * A];
+        const double* expected = &reference_probs[k * A];
+        for (int a = 0; a < A; ++a) {
+            double error = std::fabs(probs[a] - expected[a]);
+            report.max_prob_error = std::max(report.max_prob_error, error);
+            total_error += error;
+        }
+        agree += std::max_element(probs, probs + A) - probs == std::max_element(expected, expected + A) - expected;
+    }
+
+    report.mean_prob_error = total_error / (rows.size() * A);
+    report.action_agreement = static_cast<double>(agree) / rows.size();
+    report.fp64_rows_per_second = fp64_seconds > 0.0 ? rows.size() / fp64_seconds : 0.0;
+    report.int8_rows_per_second = int8_seconds > 0.0 ? rows.size() / int8_seconds : 0.0;
+    return report;
+}
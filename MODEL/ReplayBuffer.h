@@ -0,0 +1,223 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include "ExplorationPolicy.h"
+#include "PortfolioModel.h"
+
+// binary sum-tree over leaf priorities, leaf i holds the priority of ring slot i
+class SumTree {
+public:
+    explicit SumTree(size_t capacity) : leaves(1) {
+        while (leaves < capacity) leaves <<= 1;
+        nodes.assign(2 * leaves, 0.0);
+    }
+
+    void set(size_t i, double priority) {
+        size_t node = i + leaves;
+        double delta = priority - nodes[node];
+        for (; node >= 1; node >>= 1) {
+            nodes[node] += delta;
+        }
+    }
+
+    double get(size_t i) const { return nodes[i + leaves]; }
+    double total() const { return nodes[1]; }
+
+    // leaf whose cumulative range contains prefix, prefix in [0, total)
+    size_t find(double prefix) const {
+        size_t node = 1;
+        while (node < leaves) {
+            size_t left = 2 * node;
+            if (prefix < nodes[left]) {
+                node = left;
+            }
+            else {
+                prefix -= nodes[left];
+                node = left + 1;
+            }
+        }
+        return node - leaves;
+    }
+
+private:
+    size_t leaves;
+    std::vector<double> nodes;
+};
+
+struct ReplayBatch {
+    std::vector<size_t> indices;
+    std::vector<double> states;       // [batch x state_size]
+    std::vector<int> actions;
+    std::vector<double> rewards;
+    std::vector<double> weights;      // importance sampling correction, max = 1
+};
+
+// Fixed-capacity prioritized replay ring.
+// push() is lock-free and may be called from any number of rollout threads: a slot is
+// claimed with one fetch_add and guarded by a per-slot sequence (odd = being written).
+// sample() / update_priorities() belong to the single learner thread, which also owns the
+// sum-tree and folds newly published slots into it before each sample.
+class ReplayBuffer {
+public:
+    size_t capacity;
+    size_t state_size;
+    double alpha;  // 0 = uniform sampling, 1 = fully proportional to priority
+
+    ReplayBuffer(size_t capacity, size_t state_size, double alpha = 0.6)
+        : capacity(capacity), state_size(state_size), alpha(alpha),
+        stride(state_size + 1), arena(capacity * (state_size + 1), 0.0), actions(capacity, 0),
+        versions(new std::atomic<uint64_t>[capacity]), tree(capacity) {
+        for (size_t i = 0; i < capacity; ++i) {
+            versions[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void push(const double* state, int action, double reward) {
+        uint64_t ticket = write_cursor.fetch_add(1, std::memory_order_relaxed);
+        size_t slot = ticket % capacity;
+
+        uint64_t v = versions[slot].load(std::memory_order_relaxed);
+        while (true) {
+            if ((v & 1) == 0 && versions[slot].compare_exchange_weak(v, v + 1, std::memory_order_acquire)) break;
+            v = versions[slot].load(std::memory_order_relaxed);
+        }
+
+        double* record = &arena[slot * stride];
+        std::memcpy(record, state, state_size * sizeof(double));
+        record[state_size] = reward;
+        actions[slot] = action;
+
+        versions[slot].store(v + 2, std::memory_order_release);
+        published.fetch_add(1, std::memory_order_release);
+    }
+
+    void push(const std::vector<double>& state, int action, double reward) {
+        push(state.data(), action, reward);
+    }
+
+    size_t size() const {
+        return std::min<size_t>(published.load(std::memory_order_acquire), capacity);
+    }
+
+    void sample(size_t batch_size, double beta, ReplayBatch& batch, RngStream& rng = thread_rng()) {
+        sync();
+        double total = tree.total();
+        size_t n = size();
+        if (total <= 0.0 || n == 0) {
+            batch_size = 0;
+        }
+
+        batch.indices.resize(batch_size);
+        batch.states.resize(batch_size * state_size);
+        batch.actions.resize(batch_size);
+        batch.rewards.resize(batch_size);
+        batch.weights.resize(batch_size);
+
+        // stratified: one draw per equal slice of the priority mass
+        double segment = total / std::max<size_t>(batch_size, 1);
+        double max_weight = 0.0;
+        for (size_t b = 0; b < batch_size;) {
+            size_t slot = std::min(tree.find((b + rng.uniform()) * segment), capacity - 1);
+            if (!read(slot, b, batch)) {
+                continue;  // being written, draw again
+            }
+            double p = std::max(tree.get(slot) / total, 1e-12);
+            batch.indices[b] = slot;
+            batch.weights[b] = std::pow(n * p, -beta);
+            max_weight = std::max(max_weight, batch.weights[b]);
+            ++b;
+        }
+        for (size_t b = 0; b < batch_size; ++b) {
+            batch.weights[b] /= max_weight;
+        }
+    }
+
+    void update_priorities(const std::vector<size_t>& indices, const std::vector<double>& errors) {
+        update_priorities(indices, errors.data());
+    }
+
+    // errors[indices.size()]
+    void update_priorities(const std::vector<size_t>& indices, const double* errors) {
+        for (size_t i = 0; i < indices.size(); ++i) {
+            double priority = std::pow(std::fabs(errors[i]) + min_priority, alpha);
+            max_priority = std::max(max_priority, priority);
+            tree.set(indices[i], priority);
+        }
+    }
+
+private:
+    const double min_priority = 1e-6;
+
+    size_t stride;
+    std::vector<double> arena;  // per slot: state | reward
+    std::vector<int> actions;
+    std::unique_ptr<std::atomic<uint64_t>[]> versions;
+    std::atomic<uint64_t> write_cursor{ 0 };
+    std::atomic<uint64_t> published{ 0 };
+
+    // learner-only
+    SumTree tree;
+    uint64_t synced = 0;
+    double max_priority = 1.0;
+
+    // new transitions enter the tree at the current max priority so they get replayed at least once
+    void sync() {
+        uint64_t end = write_cursor.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity && synced < end - capacity ? end - capacity : synced;
+        for (uint64_t t = begin; t < end; ++t) {
+            tree.set(t % capacity, max_priority);
+        }
+        synced = end;
+    }
+
+    bool read(size_t slot, size_t b, ReplayBatch& batch) {
+        uint64_t before = versions[slot].load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) return false;
+        const double* record = &arena[slot * stride];
+        std::memcpy(&batch.states[b * state_size], record, state_size * sizeof(double));
+        batch.rewards[b] = record[state_size];
+        batch.actions[b] = actions[slot];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return versions[slot].load(std::memory_order_relaxed) == before;
+    }
+};
+
+// One prioritized minibatch REINFORCE step of the head once `replay` holds batch_size
+// transitions (states are combined LTC outputs, re-scored with the current weights);
+// learner thread only. Returns false while the buffer is still filling.
+inline bool replayUpdate(PortfolioModel& model, AdamOptimizer& adam, ReplayBuffer& replay, size_t batch_size,
+    ReplayBatch& batch, Arena& arena, int t) {
+    if (batch_size == 0 || replay.size() < batch_size) return false;
+    replay.sample(batch_size, 0.4, batch);
+    const size_t n = batch.indices.size();
+    DenseLayer& final_layer = model.final_layer;
+    const size_t weight_count = final_layer.output_size * final_layer.input_size;
+    ArenaScope scope(arena);
+    StepScratch s = model.step_scratch(arena);
+    double* dW_sum = arena.zeros<double>(weight_count);
+    double* dB_sum = arena.zeros<double>(final_layer.output_size);
+    double* errors = arena.allocate_array<double>(n);
+    for (size_t b = 0; b < n; ++b) {
+        const double* state = &batch.states[b * replay.state_size];
+        model.action_probs(state, s.action_probs);
+        int action = batch.actions[b];
+        double advantage = batch.rewards[b] * batch.weights[b];
+
+        policyGradient(s.action_probs, PortfolioModel::num_actions, action, advantage, s.grad_output);
+        final_layer.backward(state, s.grad_output, s.dW, s.dB);
+        for (size_t w = 0; w < weight_count; ++w) {
+            dW_sum[w] += s.dW[w] / n;
+        }
+        for (int i = 0; i < final_layer.output_size; ++i) {
+            dB_sum[i] += s.dB[i] / n;
+        }
+        errors[b] = batch.rewards[b] * (1 - s.action_probs[action]);
+    }
+    adam.update(final_layer.weights, final_layer.biases, dW_sum, dB_sum, t);
+    replay.update_priorities(batch.indices, errors);
+    return true;
+}
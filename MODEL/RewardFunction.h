@@ -1,4 +1,212 @@
 #pragma once
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
 #include "FinancialData.h"
 
 double compute_reward(const FinancialData& fd);
+
+// read-only view over one column (prices of a symbol, positions, ...)
+struct ColumnSpan {
+    const double* data;
+    size_t size;
+
+    double operator[](size_t i) const { return data[i]; }
+};
+
+inline double percentage_change(double price, double next_price) {
+    if (price != 0.0 && next_price != 0.0) {
+        return (next_price - price) / price;
+    }
+    return 0.0; //no data -> 0
+}
+
+// CRTP base: Derived::reward(price, next_price, position) is the per-sample kernel,
+// position is the model's allocation to the asset (probability of the long action)
+template <typename Derived>
+struct RewardFunction {
+    // reward() reads state left by the previous samples (moments, peak, last position), so
+    // a symbol's rows must reach it in date order: see DateOrderRewards
+    static constexpr bool stateful = false;
+
+    double operator()(const FinancialData& fd, double position = 1.0) {
+        return derived().reward(fd.stockPrice, fd.nextMonthStockPrice, position);
+    }
+
+    // batch over a symbol's columns in time order, position may be empty (= 1.0)
+    void evaluate(ColumnSpan price, ColumnSpan next_price, ColumnSpan position, double* out) {
+        for (size_t i = 0; i < price.size; ++i) {
+            out[i] = derived().reward(price[i], next_price[i], position.size ? position[i] : 1.0);
+        }
+    }
+
+    void reset() {}
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+struct CubedReturnReward : RewardFunction<CubedReturnReward> {
+    double reward(double price, double next_price, double) const {
+        double change = percentage_change(price, next_price);
+        return change * change * change; // exponentiel component ^3
+    }
+};
+
+struct LogReturnReward : RewardFunction<LogReturnReward> {
+    double reward(double price, double next_price, double) const {
+        double ratio = price != 0.0 ? next_price / price : 0.0;
+        return ratio > 0.0 ? std::log(ratio) : 0.0;
+    }
+};
+
+// differential Sharpe ratio (Moody & Saffell), eta = decay of the return moments
+struct SharpeReward : RewardFunction<SharpeReward> {
+    static constexpr bool stateful = true;
+    double eta = 0.01;
+    double A = 0.0;  // EMA of returns
+    double B = 0.0;  // EMA of squared returns
+
+    SharpeReward() = default;
+    explicit SharpeReward(double eta) : eta(eta) {}
+
+    double reward(double price, double next_price, double position) {
+        double r = position * percentage_change(price, next_price);
+        double dA = r - A;
+        double dB = r * r - B;
+        double variance = B - A * A;
+        double d = variance > 1e-12 ? (B * dA - 0.5 * A * dB) / (variance * std::sqrt(variance)) : 0.0;
+        A += eta * dA;
+        B += eta * dB;
+        return d;
+    }
+
+    void reset() { A = 0.0; B = 0.0; }
+};
+
+// position return minus lambda * current drawdown of the running equity
+struct DrawdownPenalizedReward : RewardFunction<DrawdownPenalizedReward> {
+    static constexpr bool stateful = true;
+    double lambda = 0.5;
+    double log_equity = 0.0;
+    double log_peak = 0.0;
+
+    DrawdownPenalizedReward() = default;
+    explicit DrawdownPenalizedReward(double lambda) : lambda(lambda) {}
+
+    double reward(double price, double next_price, double position) {
+        double r = position * percentage_change(price, next_price);
+        log_equity += std::log1p(std::max(r, -0.999));
+        log_peak = std::max(log_peak, log_equity);
+        double drawdown = 1.0 - std::exp(log_equity - log_peak);
+        return r - lambda * drawdown;
+    }
+
+    void reset() { log_equity = 0.0; log_peak = 0.0; }
+};
+
+// wraps another reward and charges cost per unit of position change
+template <typename Base>
+struct TurnoverPenalizedReward : RewardFunction<TurnoverPenalizedReward<Base>> {
+    static constexpr bool stateful = true;
+    Base base;
+    double cost = 0.001;
+    double last_position = 0.0;
+
+    TurnoverPenalizedReward() = default;
+    TurnoverPenalizedReward(Base base, double cost) : base(base), cost(cost) {}
+
+    double reward(double price, double next_price, double position) {
+        double turnover = std::fabs(position - last_position);
+        last_position = position;
+        return base.reward(price, next_price, position) - cost * turnover;
+    }
+
+    void reset() { base.reset(); last_position = 0.0; }
+};
+
+// Rewards of one pass computed in each symbol's date order, for loops that then visit the
+// rows shuffled. Rows are added in loader order (grouped by symbol, dates ascending) with the
+// position taken at each; evaluate() runs every run of one symbol through Reward::evaluate
+// with that symbol's state, which carries over between passes (streaming chunks) until
+// reset().
+template <typename Reward>
+class DateOrderRewards {
+public:
+    DateOrderRewards(size_t num_symbols, const Reward& reward_fn) : states(num_symbols, reward_fn) {}
+
+    void reset() {
+        for (auto& r : states) {
+            r.reset();
+        }
+    }
+
+    void clear() {
+        rows.clear();
+        symbols.clear();
+        price.clear();
+        next_price.clear();
+        position.clear();
+    }
+
+    void add(size_t row, size_t symbol, const FinancialData& fd, double p) {
+        rows.push_back(row);
+        symbols.push_back(static_cast<uint32_t>(symbol));
+        price.push_back(fd.stockPrice);
+        next_price.push_back(fd.nextMonthStockPrice);
+        position.push_back(p);
+    }
+
+    void evaluate() {
+        out.resize(rows.size());
+        for (size_t first = 0, last; first < rows.size(); first = last) {
+            for (last = first + 1; last < rows.size() && symbols[last] == symbols[first]; ++last) {}
+            const size_t n = last - first;
+            states[symbols[first]].evaluate({ &price[first], n }, { &next_price[first], n }, { &position[first], n }, &out[first]);
+        }
+        size_t end = 0;
+        for (size_t row : rows) end = std::max(end, row + 1);
+        by_row.resize(end);
+        for (size_t k = 0; k < rows.size(); ++k) {
+            by_row[rows[k]] = out[k];
+        }
+    }
+
+    // reward of a row added before the last evaluate()
+    double operator[](size_t row) const { return by_row[row]; }
+
+private:
+    std::vector<Reward> states;  // one per symbol
+    std::vector<size_t> rows;
+    std::vector<uint32_t> symbols;
+    std::vector<double> price, next_price, position, out, by_row;
+};
+
+enum class RewardKind { CubedReturn, LogReturn, Sharpe, DrawdownPenalized, TurnoverPenalized };
+
+inline bool parseRewardKind(const std::string& name, RewardKind& kind) {
+    if (name == "cubed") kind = RewardKind::CubedReturn;
+    else if (name == "log") kind = RewardKind::LogReturn;
+    else if (name == "sharpe") kind = RewardKind::Sharpe;
+    else if (name == "drawdown") kind = RewardKind::DrawdownPenalized;
+    else if (name == "turnover") kind = RewardKind::TurnoverPenalized;
+    else return false;
+    return true;
+}
+
+// the only runtime switch: f is instantiated once per reward type, so the
+// per-sample calls inside it are direct and inlinable
+template <typename F>
+auto withReward(RewardKind kind, F&& f) {
+    switch (kind) {
+    case RewardKind::LogReturn: return f(LogReturnReward{});
+    case RewardKind::Sharpe: return f(SharpeReward{});
+    case RewardKind::DrawdownPenalized: return f(DrawdownPenalizedReward{});
+    case RewardKind::TurnoverPenalized: return f(TurnoverPenalizedReward<CubedReturnReward>{});
+    case RewardKind::CubedReturn:
+    default: return f(CubedReturnReward{});
+    }
+}
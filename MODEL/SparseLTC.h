@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "LTC.h"
+
+// synapse list, edge (pre -> post) feeds weighted_sum of post with sigmoid(pre)
+struct Wiring {
+    int num_units = 0;
+    std::vector<std::pair<int, int>> edges;  // (post, pre)
+};
+
+// each possible synapse kept with probability density
+inline Wiring randomSparseWiring(int num_units, double density, unsigned seed = std::random_device{}()) {
+    Wiring wiring;
+    wiring.num_units = num_units;
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution keep(density);
+    for (int post = 0; post < num_units; ++post) {
+        for (int pre = 0; pre < num_units; ++pre) {
+            if (keep(gen)) wiring.edges.emplace_back(post, pre);
+        }
+    }
+    return wiring;
+}
+
+// Neural circuit policy layout (Lechner et al.): units are [inter | command | motor].
+// inter -> command with a fixed fan-out, recurrent command -> command synapses,
+// command -> motor with a fixed fan-in. The inter layer is where sensory drive lands.
+inline Wiring ncpWiring(int inter, int command, int motor,
+    int inter_fanout, int recurrent_command, int motor_fanin, unsigned seed = std::random_device{}()) {
+    Wiring wiring;
+    wiring.num_units = inter + command + motor;
+    std::mt19937 gen(seed);
+    const int command_begin = inter;
+    const int motor_begin = inter + command;
+
+    std::vector<int> targets(command);
+    for (int c = 0; c < command; ++c) targets[c] = command_begin + c;
+    for (int i = 0; i < inter; ++i) {
+        std::shuffle(targets.begin(), targets.end(), gen);
+        for (int k = 0; k < std::min(inter_fanout, command); ++k) {
+            wiring.edges.emplace_back(targets[k], i);
+        }
+    }
+
+    std::uniform_int_distribution<> pick_command(command_begin, motor_begin - 1);
+    for (int k = 0; k < recurrent_command && command > 0; ++k) {
+        wiring.edges.emplace_back(pick_command(gen), pick_command(gen));
+    }
+
+    std::vector<int> sources(command);
+    for (int c = 0; c < command; ++c) sources[c] = command_begin + c;
+    for (int m = 0; m < motor; ++m) {
+        std::shuffle(sources.begin(), sources.end(), gen);
+        for (int k = 0; k < std::min(motor_fanin, command); ++k) {
+            wiring.edges.emplace_back(motor_begin + m, sources[k]);
+        }
+    }
+    return wiring;
+}
+
+// LTCCell with W stored as CSR (row = postsynaptic unit). One unfold costs
+// O(num_units + edges) instead of O(num_units^2); same update rule as LTCCell::update_state.
+class SparseLTCCell {
+public:
+    int num_units;
+    int input_size;
+    int ode_solver_unfolds;
+
+    std::vector<int> row_ptr;     // [num_units + 1]
+    std::vector<int> col_idx;     // presynaptic unit per edge
+    std::vector<double> values;   // W per edge
+    std::vector<double> cm_t, gleak, vleak;
+
+    SparseLTCCell(int input_size, const Wiring& wiring) : num_units(wiring.num_units), input_size(input_size) {
+        ode_solver_unfolds = 6;
+        std::mt19937 gen(std::random_device{}());
+        std::uniform_real_distribution<> dis(0.01, 1.0);
+        build(wiring, [&](int, int) { return dis(gen); });
+        cm_t = std::vector<double>(num_units, 0.5);
+        gleak = std::vector<double>(num_units, 1.0);
+        vleak = std::vector<double>(num_units, 0.0);
+    }
+
+    // keeps the dense cell's weights on the wired synapses
+    SparseLTCCell(const LTCCell& dense, const Wiring& wiring)
+        : num_units(dense.num_units), input_size(dense.input_size), ode_solver_unfolds(dense.ode_solver_unfolds),
+        cm_t(dense.cm_t), gleak(dense.gleak), vleak(dense.vleak) {
+        build(wiring, [&](int post, int pre) { return dense.W[post][pre]; });
+    }
+
+    size_t num_edges() const { return values.size(); }
+
+    std::vector<double> ode_step(const std::vector<double>& /*inputs*/, const std::vector<double>& state) {
+        std::vector<double> v = state;
+        std::vector<double> activation(num_units);
+        for (int t = 0; t < ode_solver_unfolds; ++t) {
+            update_state(v, activation);
+        }
+        return v;
+    }
+
+    std::vector<double> operator()(const std::vector<double>& inputs, const std::vector<double>& state) {
+        return ode_step(inputs, state);
+    }
+
+    // one unfold in place, activation is scratch of num_units
+    void update_state(std::vector<double>& v, std::vector<double>& activation) const {
+        for (int j = 0; j < num_units; ++j) {
+            activation[j] = sigmoid(v[j]);
+        }
+        for (int i = 0; i < num_units; ++i) {
+            double weighted_sum = 0.0;
+            for (int e = row_ptr[i]; e < row_ptr[i + 1]; ++e) {
+                weighted_sum += values[e] * activation[col_idx[e]];
+            }
+            v[i] = (cm_t[i] * v[i] + gleak[i] * vleak[i] + weighted_sum) / (cm_t[i] + gleak[i]);
+        }
+    }
+
+private:
+    template <typename Weight>
+    void build(const Wiring& wiring, Weight weight) {
+        std::vector<std::pair<int, int>> edges = wiring.edges;
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        row_ptr.assign(num_units + 1, 0);
+        col_idx.resize(edges.size());
+        values.resize(edges.size());
+        for (size_t e = 0; e < edges.size(); ++e) {
+            ++row_ptr[edges[e].first + 1];
+            col_idx[e] = edges[e].second;
+            values[e] = weight(edges[e].first, edges[e].second);
+        }
+        for (int i = 0; i < num_units; ++i) {
+            row_ptr[i + 1] += row_ptr[i];
+        }
+    }
+};
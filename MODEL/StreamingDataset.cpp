@@ -0,0 +1,313 @@
+#include "StreamingDataset.h"
+#include "BinaryDataset.h"
+#include "CSVReader.h"
+#include "Calendar.h"
+#include "FeatureSchema.h"
+#include "Profiler.h"
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <cmath>
+
+namespace {
+
+class CsvRowReader : public RowReader {
+public:
+    explicit CsvRowReader(const std::string& path) : path(path) {}
+
+    bool rewind() override {
+        file.close();
+        file.clear();
+        file.open(path);
+        if (!file.is_open()) return false;
+        std::getline(file, line);  // header
+        return true;
+    }
+
+    bool next(FinancialData& fd, MacroData* md) override {
+        MacroData scratch;
+        while (std::getline(file, line)) {
+            int month;
+            if (parseFinancialDataLine(line, fd, md ? *md : scratch, month)) {
+                fd.period = month;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::string path;
+    std::ifstream file;
+    std::string line;
+};
+
+// one symbol's rows per read, like loadFinancialDataBinary
+class BinaryRowReader : public RowReader {
+public:
+    explicit BinaryRowReader(const std::string& path) : path(path) {}
+
+    bool rewind() override {
+        if (!file.is_open()) {
+            file.open(path, std::ios::binary);
+            if (!file.is_open() || !readBinaryDatasetHeader(file, header) || header.num_periods == 0) return false;
+            dates = readBinaryStrings(file, header.dates_offset, header.num_periods, header.date_width);
+            symbols = readBinaryStrings(file, header.symbols_offset, header.num_symbols, header.symbol_width);
+            months.resize(header.num_periods);
+            for (uint64_t t = 0; t < header.num_periods; ++t) {
+                if (!parseMonth(dates[t], months[t])) return false;
+            }
+            macro_values.resize(header.num_periods * header.macro_fields);
+            file.seekg(header.macro_offset);
+            file.read(reinterpret_cast<char*>(macro_values.data()), macro_values.size() * sizeof(double));
+            row_fields = binaryRowFields();
+            macro_fields = binaryMacroFields();
+        }
+        file.clear();
+        file.seekg(header.rows_offset);
+        loaded = 0;
+        t = header.num_periods;
+        return static_cast<bool>(file);
+    }
+
+    bool next(FinancialData& fd, MacroData* md) override {
+        if (t == header.num_periods) {
+            if (loaded == header.num_symbols) return false;
+            values.resize(header.num_periods * header.row_fields);
+            file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double));
+            if (!file) return false;
+            ++loaded;
+            t = 0;
+        }
+        fd.date = dates[t];
+        fd.symbol = symbols[loaded - 1];
+        fd.period = months[t];
+        for (size_t f = 0; f < row_fields.size(); ++f) {
+            fd.*(row_fields[f]->row) = values[t * header.row_fields + f];
+        }
+        if (md) {
+            md->date = dates[t];
+            for (size_t f = 0; f < macro_fields.size(); ++f) {
+                md->*(macro_fields[f]->macro) = macro_values[t * header.macro_fields + f];
+            }
+        }
+        ++t;
+        return true;
+    }
+
+private:
+    std::string path;
+    std::ifstream file;
+    BinaryDatasetHeader header{};
+    std::vector<std::string> dates, symbols;
+    std::vector<int> months;
+    std::vector<double> macro_values, values;
+    std::vector<const FeatureField*> row_fields, macro_fields;
+    uint64_t loaded = 0;  // symbols read so far
+    uint64_t t = 0;       // next period of the current symbol
+};
+
+bool isPrice(const FeatureField& field) {
+    return field.row == &FinancialData::stockPrice || field.row == &FinancialData::nextMonthStockPrice;
+}
+
+}
+
+std::unique_ptr<RowReader> makeRowReader(const std::string& path) {
+    bool binary = path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+    if (binary) return std::make_unique<BinaryRowReader>(path);
+    return std::make_unique<CsvRowReader>(path);
+}
+
+StreamingDataset::StreamingDataset(const std::string& path, const StreamingOptions& options)
+    : options(options), reader(makeRowReader(path)), rng(options.seed, 0) {
+    if (this->options.chunk_rows == 0) this->options.chunk_rows = 1;
+    ok_ = scan();
+    if (!ok_) {
+        std::cerr << "Streaming: cannot read " << path << std::endl;
+    }
+}
+
+StreamingDataset::~StreamingDataset() {
+    stop();
+}
+
+// next record with nextMonthStockPrice set: the next row of the same symbol, else its own price
+bool StreamingDataset::read(FinancialData& fd, MacroData* md) {
+    if (!has_pending) {
+        has_pending = reader->next(pending, md ? &pending_macro : nullptr);
+        if (!has_pending) return false;
+    }
+    fd = std::move(pending);
+    if (md) *md = pending_macro;
+    has_pending = reader->next(pending, md ? &pending_macro : nullptr);
+    fd.nextMonthStockPrice = has_pending && pending.symbol == fd.symbol ? pending.stockPrice : fd.stockPrice;
+    return true;
+}
+
+// first pass: macro table, symbols, periods and the moments of every row attribute
+bool StreamingDataset::scan() {
+    PROFILE_SCOPE("StreamingDataset::scan");
+    if (!reader->rewind()) return false;
+    has_pending = false;
+
+    std::vector<const FeatureField*> fields;
+    for (const FeatureField& field : featureSchema) {
+        if (field.row) fields.push_back(&field);
+    }
+    const size_t A = fields.size();
+    std::vector<double> count(A, 0.0), shift(A, 0.0), sum(A, 0.0), sum_sq(A, 0.0);
+
+    MonthTable<MacroData> months;
+    FinancialData fd;
+    MacroData md;
+    int last_month = 0;
+    while (read(fd, &md)) {
+        if (symbols_.empty() || fd.symbol != symbols_.back()) {
+            if (!symbol_index.emplace(fd.symbol, static_cast<uint32_t>(symbols_.size())).second) {
+                std::cerr << "Streaming: rows must be grouped by symbol (" << fd.symbol << " appears twice)" << std::endl;
+                return false;
+            }
+            symbols_.push_back(fd.symbol);
+        }
+        else if (fd.period <= last_month) {
+            std::cerr << "Streaming: dates must increase within a symbol (" << fd.symbol << " " << fd.date << ")" << std::endl;
+            return false;
+        }
+        last_month = fd.period;
+        if (!months.contains(fd.period)) {
+            months.add(fd.period) = md;
+        }
+
+        // shifted by the first observed value to keep the squares well conditioned
+        for (size_t a = 0; a < A; ++a) {
+            double x = fd.*(fields[a]->row);
+            if (x != x) continue;
+            if (count[a] == 0.0) shift[a] = x;
+            double d = x - shift[a];
+            count[a] += 1.0;
+            sum[a] += d;
+            sum_sq[a] += d * d;
+        }
+        ++num_rows_;
+    }
+    if (num_rows_ == 0) return false;
+
+    const Calendar& calendar = months.calendar();
+    first_month = calendar.first_month;
+    period_of_month = months.ranks();
+    for (int p = 0; p < calendar.num_months; ++p) {
+        if (months.has(p)) macro_.push_back(std::move(months.at(p)));
+    }
+    // macro table is small: the in-memory imputation and normalization apply as is
+    std::vector<FinancialData> no_rows;
+    DataValidity validity;
+    extractValidity(no_rows, macro_, validity);
+    imputeMissing(no_rows, macro_, validity);
+    normalizeData(no_rows, macro_, validity);
+
+    row_stats.resize(A);
+    for (size_t a = 0; a < A; ++a) {
+        double mean = count[a] > 0.0 ? sum[a] / count[a] : 0.0;
+        double variance = count[a] > 0.0 ? sum_sq[a] / count[a] - mean * mean : 0.0;
+        row_stats[a] = { shift[a] + mean, std::sqrt(std::max(0.0, variance)) };
+    }
+    PROFILE_COUNT("stream.scan_rows", num_rows_);
+    return true;
+}
+
+// up to chunk_rows records, forward-filled per symbol, normalized and shuffled
+size_t StreamingDataset::fill(StreamChunk& chunk) {
+    PROFILE_SCOPE("StreamingDataset::fill");
+    std::vector<const FeatureField*> fields;
+    for (const FeatureField& field : featureSchema) {
+        if (field.row) fields.push_back(&field);
+    }
+    const size_t A = fields.size();
+
+    chunk.rows.resize(options.chunk_rows);
+    chunk.symbols.resize(options.chunk_rows);
+    size_t n = 0;
+    while (n < options.chunk_rows && read(chunk.rows[n], nullptr)) {
+        FinancialData& fd = chunk.rows[n];
+        fd.period = period_of_month[fd.period - first_month];
+        if (fd.symbol != last_symbol) {
+            last_symbol = fd.symbol;
+            current_symbol = symbol_index.at(fd.symbol);
+            last_values.assign(A, std::numeric_limits<double>::quiet_NaN());
+        }
+        chunk.symbols[n] = current_symbol;
+        for (size_t a = 0; a < A; ++a) {
+            double& x = fd.*(fields[a]->row);
+            if (!isPrice(*fields[a])) {
+                last_values[a] = x == x ? x : last_values[a];
+                x = last_values[a];
+            }
+            const AttributeStats& s = row_stats[a];
+            double scale = s.stddev != 0 ? 1.0 / s.stddev : 0.0;
+            x = x == x ? (x - s.mean) * scale : 0.0;
+        }
+        ++n;
+    }
+    chunk.rows.resize(n);
+    chunk.symbols.resize(n);
+    chunk.order = EpochOrder(n, options.shuffle_block);
+    if (options.shuffle) chunk.order.shuffle(rng);
+    PROFILE_COUNT("stream.rows", n);
+    return n;
+}
+
+void StreamingDataset::produce() {
+    for (size_t k = 0;; ++k) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // buffers[k % 2] held chunk k - 2
+            cv.wait(lock, [&] { return stopping || k < released + 2; });
+            if (stopping) return;
+        }
+        size_t n = fill(buffers[k % 2]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (n == 0) finished = true;
+            else produced = k + 1;
+        }
+        cv.notify_all();
+        if (n == 0) return;
+    }
+}
+
+void StreamingDataset::start_epoch() {
+    stop();
+    produced = released = taken = 0;
+    finished = false;
+    has_pending = false;
+    last_symbol.clear();
+    if (!ok_ || !reader->rewind()) {
+        finished = true;
+        return;
+    }
+    io = std::thread(&StreamingDataset::produce, this);
+}
+
+const StreamChunk* StreamingDataset::next_chunk() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (taken > released) {
+        released = taken;  // done with the previous chunk, its buffer can be refilled
+        cv.notify_all();
+    }
+    cv.wait(lock, [&] { return produced > taken || finished; });
+    if (produced > taken) {
+        return &buffers[taken++ % 2];
+    }
+    return nullptr;
+}
+
+void StreamingDataset::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (io.joinable()) io.join();
+    stopping = false;
+}
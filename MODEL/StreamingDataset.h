@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include "FinancialData.h"
+#include "DataPreprocessing.h"
+#include "EpochOrder.h"
+
+// Raw rows in file order, grouped by symbol with dates ascending within a symbol (what the
+// collector and the generator write). Missing values are NaN and fd.period holds the month
+// index (Calendar.h); nextMonthStockPrice is filled by the caller.
+class RowReader {
+public:
+    virtual ~RowReader() = default;
+    virtual bool rewind() = 0;
+    // md == nullptr skips the macro columns
+    virtual bool next(FinancialData& fd, MacroData* md) = 0;
+};
+
+// .bin = BinaryDataset.h format, anything else financial_data.csv
+std::unique_ptr<RowReader> makeRowReader(const std::string& path);
+
+struct StreamingOptions {
+    size_t chunk_rows = size_t(1) << 16;  // rows per buffer, two buffers live at once
+    bool shuffle = true;                  // shuffle rows within each chunk (bounded window)
+    size_t shuffle_block = 0;             // EpochOrder block size within the chunk
+    uint64_t seed = 0x5eed;
+};
+
+struct StreamChunk {
+    std::vector<FinancialData> rows;  // normalized, missing features forward-filled
+    std::vector<uint32_t> symbols;    // symbol index of each row
+    EpochOrder order;                 // visit order within the chunk
+};
+
+// Out-of-core dataset: a first pass over the file keeps only the macro table, the symbol
+// list and per-attribute moments; each epoch then streams the rows again in chunks. An I/O
+// thread reads and prepares chunk k + 1 while the caller trains on chunk k, so memory is two
+// chunks plus O(months + symbols), whatever the number of rows.
+// Compared with the in-memory path: z-scores use statistics over observed values and
+// leading gaps of a symbol are left at the mean (no cross-sectional median).
+class StreamingDataset {
+public:
+    StreamingDataset(const std::string& path, const StreamingOptions& options);
+    ~StreamingDataset();
+
+    StreamingDataset(const StreamingDataset&) = delete;
+    StreamingDataset& operator=(const StreamingDataset&) = delete;
+
+    bool ok() const { return ok_; }
+    const std::vector<MacroData>& macro() const { return macro_; }  // normalized, one per period
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    size_t num_rows() const { return num_rows_; }
+
+    // rewinds the file and starts the I/O thread for one pass
+    void start_epoch();
+    // next chunk of the pass, nullptr at the end; valid until the next call
+    const StreamChunk* next_chunk();
+
+private:
+    bool read(FinancialData& fd, MacroData* md);
+    bool scan();
+    void produce();
+    size_t fill(StreamChunk& chunk);
+    void stop();
+
+    StreamingOptions options;
+    std::unique_ptr<RowReader> reader;
+    bool ok_ = false;
+
+    std::vector<MacroData> macro_;
+    std::vector<std::string> symbols_;
+    std::unordered_map<std::string, uint32_t> symbol_index;
+    int first_month = 0;
+    std::vector<int> period_of_month;  // calendar period -> dense period
+    std::vector<AttributeStats> row_stats;  // featureSchema row fields, in order
+    size_t num_rows_ = 0;
+
+    // I/O thread state: one record of lookahead for nextMonthStockPrice, forward-fill values
+    FinancialData pending;
+    MacroData pending_macro;
+    bool has_pending = false;
+    std::vector<double> last_values;
+    std::string last_symbol;
+    uint32_t current_symbol = 0;
+    RngStream rng;
+
+    // double buffer: chunk k lives in buffers[k % 2]
+    StreamChunk buffers[2];
+    std::thread io;
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t produced = 0;   // chunks ready
+    size_t released = 0;   // chunks the trainer is done with
+    size_t taken = 0;      // chunks handed out
+    bool finished = false;
+    bool stopping = false;
+};
@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+namespace {
+
+// queue owned by the current thread, if it is a worker of that pool
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+std::mutex instance_mutex;
+std::unique_ptr<ThreadPool> shared_pool;
+
+int defaultThreads() {
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+}
+
+ThreadPool::ThreadPool(int threads) : threads(std::max(1, threads)) {
+    const size_t count = static_cast<size_t>(std::max(1, this->threads - 1));
+    for (size_t w = 0; w < count; ++w) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t w = 0; w < count; ++w) {
+        workers.emplace_back(&ThreadPool::work, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance() {
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    if (!shared_pool) shared_pool = std::make_unique<ThreadPool>(defaultThreads());
+    return *shared_pool;
+}
+
+void ThreadPool::configure(int threads) {
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    threads = threads > 0 ? threads : defaultThreads();
+    if (shared_pool && shared_pool->concurrency() == threads) return;
+    shared_pool.reset();
+    shared_pool = std::make_unique<ThreadPool>(threads);
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // workers keep their own tasks, other threads spread theirs over the queues
+    size_t queue = current_pool == this ? current_queue : next_queue.fetch_add(1) % queues.size();
+    pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    { std::lock_guard<std::mutex> lock(sleep_mutex); }
+    sleep_cv.notify_one();
+}
+
+void ThreadPool::notify_all() {
+    { std::lock_guard<std::mutex> lock(sleep_mutex); }
+    sleep_cv.notify_all();
+}
+
+bool ThreadPool::pop(size_t queue, bool back, std::function<void()>& task) {
+    WorkerQueue& q = *queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    if (back) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+    }
+    else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+    }
+    return true;
+}
+
+bool ThreadPool::run_one() {
+    const bool own = current_pool == this;
+    const size_t first = own ? current_queue : next_queue.load() % queues.size();
+    std::function<void()> task;
+    // own queue from the back, then steal the oldest task of the others
+    bool found = own && pop(first, true, task);
+    for (size_t k = own ? 1 : 0; !found && k < queues.size(); ++k) {
+        found = pop((first + k) % queues.size(), false, task);
+    }
+    if (!found) return false;
+    pending.fetch_sub(1);
+    task();
+    return true;
+}
+
+void ThreadPool::work(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        if (run_one()) continue;
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [&] { return stopping || pending.load() > 0; });
+        if (stopping && pending.load() == 0) return;
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+// Work-stealing pool shared by every parallel stage (search, walk-forward, actors, generator,
+// normalization), so nested or concurrent stages share one set of threads instead of each
+// spawning its own. Every worker owns a deque: it pushes and pops at the back (most recent
+// task, warm in cache), idle workers steal from the front of the others. Threads waiting on
+// a TaskGroup run queued tasks meanwhile, so nested parallel loops cannot deadlock.
+class ThreadPool {
+public:
+    // threads = total concurrency including the calling thread; at least one worker is
+    // started so tasks that block on the caller (actors feeding the learner) make progress
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // the shared pool, hardware concurrency unless configure() was called first
+    static ThreadPool& instance();
+    // resizes the shared pool (--threads); call before any parallel work
+    static void configure(int threads);
+
+    int concurrency() const { return threads; }
+
+    void submit(std::function<void()> task);
+    // runs one queued task on the calling thread, false if none was found
+    bool run_one();
+    // runs queued tasks until done() holds, sleeping while there is nothing to run
+    template <typename Done>
+    void help_until(Done&& done) {
+        while (!done()) {
+            if (run_one()) continue;
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleep_cv.wait(lock, [&] { return done() || pending.load() > 0; });
+        }
+    }
+    // wakes threads in help_until after a condition they wait on changed
+    void notify_all();
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool pop(size_t queue, bool back, std::function<void()>& task);
+    void work(size_t index);
+
+    int threads;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending{ 0 };      // queued, not yet started
+    std::atomic<size_t> next_queue{ 0 };   // round robin for submissions from outside the pool
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool stopping = false;
+};
+
+// Tasks that are waited on together. wait() runs queued tasks while the group is busy and
+// rethrows the first exception a task threw.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::instance()) : pool(pool) {}
+    ~TaskGroup() { pool.help_until([&] { return unfinished.load() == 0; }); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template <typename F>
+    void run(F&& fn) {
+        unfinished.fetch_add(1);
+        pool.submit([this, fn = std::forward<F>(fn)]() mutable {
+            try {
+                fn();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+            }
+            ThreadPool& owner = pool;  // the group may be gone once unfinished reaches 0
+            if (unfinished.fetch_sub(1) == 1) owner.notify_all();
+        });
+    }
+
+    void wait() {
+        pool.help_until([&] { return unfinished.load() == 0; });
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    ThreadPool& pool;
+    std::atomic<size_t> unfinished{ 0 };
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+// fn(i) for i in [0, count) on up to `threads` threads of the pool (0 = all of it), the
+// caller included. Indices are claimed `grain` at a time, so uneven items balance out.
+template <typename F>
+void parallelFor(size_t count, int threads, F&& fn, size_t grain = 1) {
+    ThreadPool& pool = ThreadPool::instance();
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (count + grain - 1) / grain;
+    const size_t workers = std::min<size_t>(threads > 0 ? threads : pool.concurrency(), chunks);
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&] {
+        for (size_t c = next.fetch_add(1); c < chunks; c = next.fetch_add(1)) {
+            const size_t end = std::min(count, (c + 1) * grain);
+            for (size_t i = c * grain; i < end; ++i) {
+                fn(i);
+            }
+        }
+    };
+    if (workers <= 1) {
+        worker();
+        return;
+    }
+    TaskGroup group(pool);
+    for (size_t w = 1; w < workers; ++w) {
+        group.run(worker);
+    }
+    worker();
+    group.wait();
+}
+
+// combine(map(i)...) over [0, count). Partials cover fixed blocks of `grain` indices and are
+// combined in block order, so the result does not depend on the schedule.
+template <typename T, typename Map, typename Combine>
+T parallelReduce(size_t count, int threads, T identity, Map&& map, Combine&& combine, size_t grain = 1024) {
+    grain = std::max<size_t>(grain, 1);
+    const size_t blocks = (count + grain - 1) / grain;
+    std::vector<T> partials(blocks, identity);
+    parallelFor(blocks, threads, [&](size_t b) {
+        T partial = identity;
+        const size_t end = std::min(count, (b + 1) * grain);
+        for (size_t i = b * grain; i < end; ++i) {
+            partial = combine(partial, map(i));
+        }
+        partials[b] = partial;
+    });
+    T result = identity;
+    for (const T& partial : partials) {
+        result = combine(result, partial);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+// Null bitmap, one bit per value (set = observed), 64 values per word
+class ValidityMask {
+public:
+    ValidityMask() = default;
+    explicit ValidityMask(size_t size, bool valid = false)
+        : size_(size), words((size + 63) / 64, valid ? ~uint64_t(0) : 0) {
+        if (valid && size % 64) words.back() = (uint64_t(1) << (size % 64)) - 1;
+    }
+
+    size_t size() const { return size_; }
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1u; }
+    void set(size_t i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(size_t i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    size_t count() const {
+        size_t n = 0;
+        for (uint64_t w : words) n += std::bitset<64>(w).count();
+        return n;
+    }
+    bool all() const { return count() == size_; }
+
+    // 1.0 / 0.0 per value, for branch-free column arithmetic
+    void to_weights(std::vector<double>& weights) const {
+        weights.resize(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            weights[i] = static_cast<double>((words[i >> 6] >> (i & 63)) & 1u);
+        }
+    }
+    void from_weights(const std::vector<double>& weights) {
+        *this = ValidityMask(weights.size());
+        for (size_t w = 0; w < words.size(); ++w) {
+            uint64_t word = 0;
+            const size_t begin = w * 64, end = std::min(begin + 64, size_);
+            for (size_t i = begin; i < end; ++i) {
+                word |= static_cast<uint64_t>(weights[i] != 0.0) << (i - begin);
+            }
+            words[w] = word;
+        }
+    }
+
+    std::vector<uint64_t>& bits() { return words; }
+    const std::vector<uint64_t>& bits() const { return words; }
+
+private:
+    size_t size_ = 0;
+    std::vector<uint64_t> words;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "DataPreprocessing.h"
+#include "HyperparameterSearch.h"
+
+// Walk-forward evaluation: each fold trains on months before its test window only, with
+// z-scores computed on the training window, so nothing from the future leaks into either
+// the model or its inputs.
+struct WalkForwardConfig {
+    int min_train_periods = 36;  // first fold's training months
+    int test_periods = 12;
+    int step_periods = 0;        // between test windows, 0 = test_periods
+    int window_periods = 0;      // rolling training window, 0 = expanding
+    int threads = 0;             // folds in parallel, 0 = all of the shared ThreadPool
+};
+
+struct Fold {
+    int train_first, train_last;  // [first, last) periods
+    int test_first, test_last;
+};
+
+struct FoldResult {
+    Fold fold;
+    size_t train_rows = 0;
+    size_t test_rows = 0;
+    double out_of_sample_score = 0.0;  // Trial::evaluate on the test window
+    std::vector<double> epoch_scores;  // test score after every epoch
+};
+
+inline std::vector<Fold> walkForwardFolds(int num_periods, const WalkForwardConfig& config) {
+    std::vector<Fold> folds;
+    int step = config.step_periods > 0 ? config.step_periods : config.test_periods;
+    for (int split = config.min_train_periods; split < num_periods; split += step) {
+        Fold fold;
+        fold.train_first = config.window_periods > 0 ? std::max(0, split - config.window_periods) : 0;
+        fold.train_last = split;
+        fold.test_first = split;
+        fold.test_last = std::min(num_periods, split + config.test_periods);
+        folds.push_back(fold);
+    }
+    return folds;
+}
+
+// data and macro are raw (not normalized), validity marks their observed values (empty = all).
+// Cumulative moments are computed once and every fold reads its normalization statistics
+// from them in O(attributes); missing values are left out of them and become 0.0.
+template <typename Reward>
+std::vector<FoldResult> runWalkForward(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro,
+    const DataValidity& validity, const PricePanel& panel, const Reward& reward_fn, const Hyperparameters& params,
+    const SearchOptions& options, const WalkForwardConfig& config) {
+
+    const NormalizationMoments moments(data, macro, validity);
+    const std::vector<Fold> folds = walkForwardFolds(static_cast<int>(macro.size()), config);
+    std::vector<FoldResult> results(folds.size());
+
+    parallelFor(folds.size(), config.threads, [&](size_t f) {
+        const Fold& fold = folds[f];
+        FoldResult& result = results[f];
+        result.fold = fold;
+
+        // the fold's rows and the macro table, z-scored with training-window statistics
+        std::vector<FinancialData> fold_data;
+        std::vector<size_t> fold_rows;
+        for (size_t r = 0; r < data.size(); ++r) {
+            if (data[r].period >= fold.train_first && data[r].period < fold.test_last) {
+                fold_data.push_back(data[r]);
+                fold_rows.push_back(r);
+            }
+        }
+        std::vector<MacroData> fold_macro = macro;
+        applyNormalization(fold_data, fold_macro, moments.stats(fold.train_first, fold.train_last), selectRows(validity, fold_rows));
+
+        SearchDataset dataset(fold_data, fold_macro, panel, fold.train_first, fold.test_first, fold.test_last);
+        result.train_rows = dataset.train_rows.size();
+        result.test_rows = dataset.validation_rows.size();
+
+        Trial<Reward> trial(static_cast<int>(f), params, options, reward_fn, dataset.num_symbols);
+        for (int epoch = 0; epoch < params.epochs; ++epoch) {
+            trial.train_epoch(dataset);
+            result.epoch_scores.push_back(trial.evaluate(dataset));
+        }
+        result.out_of_sample_score = result.epoch_scores.empty() ? 0.0 : result.epoch_scores.back();
+    });
+    return results;
+}
@@ -1,11 +1,23 @@
-#include "LTC.h"
-#include "DenseLayer.h"
+#include "PortfolioModel.h"
 #include "AdamOptimizer.h"
-#include "EpsilonGreedyPolicy.h"
+#include "ExplorationPolicy.h"
 #include "FinancialData.h"
 #include "CSVReader.h"
+#include "BinaryDataset.h"
 #include "DataPreprocessing.h"
 #include "RewardFunction.h"
+#include "Backtest.h"
+#include "ReplayBuffer.h"
+#include "ActorLearner.h"
+#include "CrossAssetModel.h"
+#include "HyperparameterSearch.h"
+#include "StreamingDataset.h"
+#include "WalkForward.h"
+#include "ThreadPool.h"
+#include "Quantized.h"
+#include "ModelFile.h"
+#include "Distributed.h"
+#include "Profiler.h"
 #include <iostream>
 #include <vector>
 #include <random>
@@ -13,164 +25,726 @@
 #include <algorithm>
 #include <functional>
 #include <cmath>
-
-std::vector<double> concat(const std::vector<double>& v1, const std::vector<double>& v2) {
-    std::vector<double> result = v1;
-    result.insert(result.end(), v2.begin(), v2.end());
-    return result;
+#include <chrono>
+#include <sstream>
+
+struct RunOptions {
+    PolicyKind policy = PolicyKind::EpsilonGreedy;
+    size_t replay_batch = 0;         // 0 = pure on-policy
+    size_t replay_capacity = 100000;
+    int actors = 0;                  // > 0 = async rollout threads + learner
+    bool cross_asset = false;        // whole-universe model, softmax over symbols
+    size_t shuffle_block = 0;        // EpochOrder block size of the search and --stream, 0 = uniform permutation
+    bool search = false;             // tune params first, then train with the best trial
+    SearchOptions search_options;
+    Hyperparameters params;
+    bool quantize = false;           // score with the int8 model after training, report vs fp64
+    std::string save_model;          // trained PortfolioModel for compile_model, empty = not saved
+    bool stream = false;             // out-of-core: train on chunks read by an I/O thread
+    StreamingOptions streaming;
+    bool walk_forward = false;       // out-of-sample folds only, data and macro stay raw
+    WalkForwardConfig walk_forward_config;
+    bool distributed = false;        // one rank of a data-parallel ring (--world / --rank)
+    DistributedConfig distributed_config;
+};
+
+void printBacktest(const PricePanel& panel, const std::vector<double>& long_probs) {
+    BacktestConfig backtest_config;
+    BacktestResult backtest = runBacktest(panel, long_probs, backtest_config);
+    std::cout << "Backtest: " << panel.num_symbols() << " symbols, " << panel.num_periods() << " months" << std::endl;
+    std::cout << "Total Return: " << backtest.total_return
+        << " - Annualized Return: " << backtest.annualized_return
+        << " - Volatility: " << backtest.annualized_volatility
+        << " - Sharpe: " << backtest.sharpe << std::endl;
+    std::cout << "Max Drawdown: " << backtest.max_drawdown
+        << " - Avg Turnover: " << backtest.average_turnover
+        << " - Total Costs: " << backtest.total_costs << std::endl;
 }
 
-void extractInputs(const FinancialData& fd,
-    std::vector<double>& inputs_macro,
-    std::vector<double>& inputs_accounting,
-    std::vector<double>& inputs_market) {
-    // Inputs Macro
-    inputs_macro.clear();
-    inputs_macro.push_back(fd.interestRate);
-    inputs_macro.push_back(fd.unemploymentRate);
-    inputs_macro.push_back(fd.inflation);
-    inputs_macro.push_back(fd.growthRate);
-    inputs_macro.push_back(fd.consumerSentiment);
-
-    // Inputs accounting
-    inputs_accounting.clear();
-    inputs_accounting.push_back(fd.salesFigures);
-    inputs_accounting.push_back(fd.grossMargin);
-    inputs_accounting.push_back(fd.selfFinancingCapacity);
-    inputs_accounting.push_back(fd.netIncome);
-    inputs_accounting.push_back(fd.profitPerStock);
-    inputs_accounting.push_back(fd.freeCashFlow);
-    inputs_accounting.push_back(fd.netDebtToEquity);
-    inputs_accounting.push_back(fd.roa);
-    inputs_accounting.push_back(fd.ebitda);
-
-    // Inputs Market
-    inputs_market.clear();
-    inputs_market.push_back(fd.stockPrice);
-    inputs_market.push_back(fd.sectorSentiment);
-    inputs_market.push_back(fd.beta);
-    inputs_market.push_back(fd.dividendYield);
-    inputs_market.push_back(fd.sharpeRatio);
-    inputs_market.push_back(fd.cagr);
-    inputs_market.push_back(fd.var);
-    inputs_market.push_back(fd.cvar);
+// per-integration cost of the adaptive solver against the fixed unfolds it replaces
+template <typename Model>
+void reportOdeStats(Model& model, const Hyperparameters& params) {
+    if (params.solver != ODESolver::Adaptive) return;
+    ODEStats stats = model.take_ode_stats();
+    std::cout << "ODE: " << stats.calls << " integrations - Evaluations/integration: " << stats.evaluations_per_call()
+        << " (fixed: " << params.ode_solver_unfolds << ") - Accepted: " << stats.accepted << " - Rejected: " << stats.rejected
+        << " - Early exits: " << stats.early_exits << std::endl;
 }
 
-std::vector<double> softmax(const std::vector<double>& logits) {
-    std::vector<double> exp_logits(logits.size());
-    double max_logit = *std::max_element(logits.begin(), logits.end());
-    double sum_exp = 0.0;
-    for (size_t i = 0; i < logits.size(); ++i) {
-        exp_logits[i] = std::exp(logits[i] - max_logit); // stabilisation
-        sum_exp += exp_logits[i];
+template <typename Reward>
+int run(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro, const DataValidity& validity,
+    const PricePanel& panel, const Reward& reward_fn, const RunOptions& options) {
+
+    Hyperparameters params = options.params;
+    if (options.walk_forward) {
+        SearchOptions fold_options = options.search_options;
+        fold_options.policy = options.policy;
+        std::vector<FoldResult> folds = runWalkForward(data, macro, validity, panel, reward_fn, params, fold_options, options.walk_forward_config);
+
+        double total = 0.0;
+        for (const FoldResult& r : folds) {
+            std::cout << "Fold: train " << macro[r.fold.train_first].date << " - " << macro[r.fold.train_last - 1].date
+                << " (" << r.train_rows << " rows) - test " << macro[r.fold.test_first].date << " - " << macro[r.fold.test_last - 1].date
+                << " (" << r.test_rows << " rows) - Score: " << r.out_of_sample_score << std::endl;
+            total += r.out_of_sample_score;
+        }
+        std::cout << "Walk-forward: " << folds.size() << " folds - Mean Score: " << (folds.empty() ? 0.0 : total / folds.size()) << std::endl;
+        PROFILE_SUMMARY(std::cout, "Walk-forward");
+        return 0;
     }
-    for (size_t i = 0; i < logits.size(); ++i) {
-        exp_logits[i] /= sum_exp;
+    if (options.search) {
+        SearchOptions search_options = options.search_options;
+        search_options.policy = options.policy;
+        SearchDataset dataset(data, macro, panel, search_options.validation_fraction);
+        SearchResult search = HyperparameterSearch<Reward>(dataset, reward_fn, search_options).run();
+
+        std::vector<TrialResult> ranked = search.trials;
+        std::sort(ranked.begin(), ranked.end(), [](const TrialResult& a, const TrialResult& b) { return a.score > b.score; });
+        std::cout << "Search: " << ranked.size() << " trials, " << search.epochs_used << " epochs" << std::endl;
+        for (size_t i = 0; i < std::min<size_t>(5, ranked.size()); ++i) {
+            const TrialResult& r = ranked[i];
+            std::cout << "Trial " << r.id << " - Score: " << r.score << " - Epochs: " << r.epochs
+                << " - Units: " << r.params.num_units_macro << "/" << r.params.num_units_accounting << "/" << r.params.num_units_market
+                << " - Unfolds: " << r.params.ode_solver_unfolds << " - LR: " << r.params.learning_rate
+                << " - Epsilon: " << r.params.epsilon << std::endl;
+        }
+        params = search.best.params;
+        PROFILE_SUMMARY(std::cout, "Search");
     }
-    return exp_logits;
-}
-
-int main() {
-
-    std::vector<FinancialData> data = loadFinancialData("financial_data.csv");
-
-    normalizeData(data);
 
-    int num_units_macro = 5;         // nb neurons 
-    int num_units_accounting = 5;    // nb neurons 
-    int num_units_market = 5;        // nb neurons 
+    int num_units_macro = params.num_units_macro;            // nb neurons 
+    int num_units_accounting = params.num_units_accounting;  // nb neurons 
+    int num_units_market = params.num_units_market;          // nb neurons 
 
-    int input_size_macro = 5;        // nb input macro
-    int input_size_accounting = 9;   // nb accounting inputs
-    int input_size_market = 8;       // nb markets inputs
-
-    LTCCell ltc_macro(num_units_macro, input_size_macro);
-    LTCCell ltc_accounting(num_units_accounting, input_size_accounting);
-    LTCCell ltc_market(num_units_market, input_size_market);
-
-
-    std::vector<double> state_macro(num_units_macro, 0.0);
-    std::vector<double> state_accounting(num_units_accounting, 0.0);
-    std::vector<double> state_market(num_units_market, 0.0);
-
-    int combined_output_size = num_units_macro + num_units_accounting + num_units_market;
-    DenseLayer final_layer(combined_output_size, 2); 
+    PortfolioModel model(num_units_macro, num_units_accounting, num_units_market);
+    for (LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+        cell->ode_solver_unfolds = params.ode_solver_unfolds;
+        cell->solver = params.solver;
+        cell->adaptive = params.ode;
+    }
+    model.repack();
+    DenseLayer& final_layer = model.final_layer;
+    int combined_output_size = model.combined_output_size();
 
-    AdamOptimizer adam(0.001, 0.9, 0.999, 1e-8);
+    AdamOptimizer adam(params.learning_rate, params.beta1, params.beta2, 1e-8);
     adam.initialize(final_layer.weights, final_layer.biases);
 
-    EpsilonGreedyPolicy policy(0.1);  
-    double epsilon_decay = 0.995;
+    ExplorationPolicy policy(options.policy, params.epsilon);
+    double epsilon_decay = params.epsilon_decay;
 
-    int epochs = 10; 
+    int epochs = params.epochs; 
     std::unordered_map<std::string, double> cumulative_rewards;
 
+    // stateful rewards (sharpe, drawdown, turnover) are scored per symbol in date order
+    // before each shuffled epoch, at the positions of the epoch's starting weights
+    Reward reward_of_row = reward_fn;
+    DateOrderRewards<Reward> series(panel.num_symbols(), reward_fn);
 
-    std::random_device rd;
-    std::mt19937 g(rd());
+    const int long_action = 0;  // action read as "hold the asset" by the backtest
+    std::vector<double> long_probs(panel.prices.size(), 0.0);
 
-    for (int epoch = 0; epoch < epochs; ++epoch) {
-        std::shuffle(data.begin(), data.end(), g);
+    // transitions: combined LTC output the action was taken on, action, reward
+    ReplayBuffer replay(options.replay_batch ? options.replay_capacity : 1, combined_output_size);
+    ReplayBatch replay_batch;
 
-        for (const auto& fd : data) {
-            std::vector<double> inputs_macro, inputs_accounting, inputs_market;
-            extractInputs(fd, inputs_macro, inputs_accounting, inputs_market);
+    std::random_device rd;
+    std::mt19937 g(rd());
 
-            std::vector<double> new_state_macro = ltc_macro(inputs_macro, state_macro);
-            std::vector<double> new_state_accounting = ltc_accounting(inputs_accounting, state_accounting);
-            std::vector<double> new_state_market = ltc_market(inputs_market, state_market);
+    if (options.cross_asset) {
+        CrossAssetModel cross(num_units_macro, num_units_accounting, num_units_market, 8, params.learning_rate);
+        for (LTCCell* cell : { &cross.ltc_macro, &cross.ltc_accounting, &cross.ltc_market }) {
+            cell->ode_solver_unfolds = params.ode_solver_unfolds;
+            cell->solver = params.solver;
+            cell->adaptive = params.ode;
+        }
+        std::vector<MonthBatch> months = groupByMonth(data, panel);
+        std::vector<double> asset_returns;
+        auto monthReturns = [&](const MonthBatch& month) {
+            asset_returns.resize(month.rows.size());
+            for (size_t i = 0; i < month.rows.size(); ++i) {
+                size_t c = panel.cell(data[month.rows[i]]);
+                bool valid = panel.prices[c] > 0.0 && panel.next_prices[c] > 0.0;
+                asset_returns[i] = valid ? panel.next_prices[c] / panel.prices[c] - 1.0 : 0.0;
+            }
+        };
+
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            std::shuffle(months.begin(), months.end(), g);
+            double total = 0.0;
+            for (const auto& month : months) {
+                cross.forward(data, macro, month.rows);
+                monthReturns(month);
+                total += cross.update(asset_returns, epoch + 1);
+            }
+            std::cout << "Epoch: " << epoch << " - Avg Monthly Portfolio Return: " << total / months.size() << std::endl;
+            reportOdeStats(cross, params);
+            PROFILE_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
+        }
 
-            std::vector<double> combined_output = concat(new_state_macro, new_state_accounting);
-            combined_output = concat(combined_output, new_state_market);
+        // the backtest normalizes scores per month, so the weights pass through unchanged
+        for (const auto& month : months) {
+            cross.forward(data, macro, month.rows);
+            for (size_t i = 0; i < month.rows.size(); ++i) {
+                long_probs[panel.cell(data[month.rows[i]])] = cross.weights[i];
+            }
+        }
+    }
+    else if (options.actors > 0) {
+        // data is still in loader order: grouped by symbol, sorted by date
+        ActorLearnerOptions actor_options;
+        actor_options.num_actors = options.actors;
+        actor_options.long_action = long_action;
+        actor_options.replay = &replay;
+        actor_options.replay_batch = options.replay_batch;
+        std::vector<ActorLearnerStats> stats = trainActorLearner(model, adam, policy, epsilon_decay, epochs,
+            data, macro, panel, reward_fn, long_probs, actor_options);
+        for (size_t epoch = 0; epoch < stats.size(); ++epoch) {
+            std::cout << "Epoch: " << epoch << " - Updates: " << stats[epoch].updates
+                << " - Avg Staleness: " << stats[epoch].average_staleness
+                << " - Full Queue Retries: " << stats[epoch].full_queue_retries << std::endl;
+        }
+        PROFILE_SUMMARY(std::cout, "Actor-learner");
+        ALLOCATION_SUMMARY(std::cout, "Actor-learner");
+    }
+    else {
+        std::vector<double> macro_outputs;
+        // per-month temporaries, rewound after every month and replay minibatch
+        Arena& arena = threadArena();
+        // one batch per month, months and their rows in random order: the month's symbols are
+        // scored, then one select_actions call picks all their actions (with dirichlet, one
+        // allocation across the month), then each row updates the head in turn
+        std::vector<MonthBatch> months = groupByMonth(data, panel);
+        const size_t A = PortfolioModel::num_actions;
+        policy.hold_action = long_action;
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            std::shuffle(months.begin(), months.end(), g);
+
+            model.encode_months(macro, macro_outputs);
+            if constexpr (Reward::stateful) {
+                // data is in loader order: by symbol, then date
+                series.reset();
+                series.clear();
+                for (size_t r = 0; r < data.size(); ++r) {
+                    ArenaScope step(arena);
+                    StepScratch s = model.step_scratch(arena);
+                    model.encode(data[r], macro_outputs, s.combined_output);
+                    model.action_probs(s.combined_output, s.action_probs);
+                    series.add(r, panel.symbol_index.at(data[r].symbol), data[r], s.action_probs[long_action]);
+                }
+                series.evaluate();
+            }
+            for (MonthBatch& month : months) {
+                std::shuffle(month.rows.begin(), month.rows.end(), g);
+                const size_t n = month.rows.size();
+                ArenaScope step(arena);
+                double* outputs = arena.allocate_array<double>(n * combined_output_size);
+                double* probs = arena.allocate_array<double>(n * A);
+                int* actions = arena.allocate_array<int>(n);
+                model.score_rows(n, [&](size_t i) -> const FinancialData& { return data[month.rows[i]]; },
+                    macro_outputs, outputs, probs);
+                policy.select_actions(probs, n, A, actions);
+
+                StepScratch s = model.step_scratch(arena);
+                for (size_t i = 0; i < n; ++i) {
+                    const size_t row = month.rows[i];
+                    const FinancialData& fd = data[row];
+                    s.combined_output = outputs + i * combined_output_size;
+                    s.action_probs = probs + i * A;
+
+                    if (epoch == epochs - 1) {
+                        long_probs[panel.cell(fd)] = s.action_probs[long_action];
+                    }
+
+                    double reward = Reward::stateful ? series[row] : reward_of_row(fd, s.action_probs[long_action]);
+
+                    cumulative_rewards[fd.symbol] += reward;
+
+
+                    double advantage = reward;
+
+                    // backprop
+                    model.policy_update(s, actions[i], advantage, adam, epoch + 1);
+
+                    if (options.replay_batch > 0) {
+                        replay.push(s.combined_output, actions[i], reward);
+                        replayUpdate(model, adam, replay, options.replay_batch, replay_batch, arena, epoch + 1);
+                    }
+                }
+            }
+            policy.decay_epsilon(epsilon_decay);
 
 
-            std::vector<double> logits = final_layer.forward(combined_output);
-            std::vector<double> action_probs = softmax(logits);
+            if (epoch % 1 == 0) {
+                std::cout << "Epoch: " << epoch << std::endl;
+                reportOdeStats(model, params);
+                for (const auto& pair : cumulative_rewards) {
+                    const std::string& symbol = pair.first;
+                    double reward = pair.second;
+                    std::cout << "Symbol: " << symbol << " - Cumulative Reward: " << reward << std::endl;
+                }
+                PROFILE_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
+                ALLOCATION_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
 
 
-            int action = policy.select_action(action_probs);
 
+            }
+        }
+    }
 
-            double reward = compute_reward(fd);
+    if (!options.save_model.empty() && !options.cross_asset && saveModel(options.save_model, model)) {
+        std::cout << "Model saved: " << options.save_model << std::endl;
+    }
 
-            cumulative_rewards[fd.symbol] += reward;
+    // int8 scoring: calibrated on the held-out last months, compared with fp64 on the others,
+    // then every row is rescored for the backtest
+    if (options.quantize && !options.cross_asset) {
+        const int split = static_cast<int>(std::lround(panel.num_periods() * (1.0 - options.search_options.validation_fraction)));
+        std::vector<size_t> calibration_rows, report_rows;
+        for (size_t r = 0; r < data.size(); ++r) {
+            (data[r].period >= split ? calibration_rows : report_rows).push_back(r);
+        }
+        QuantizedPortfolioModel quantized(model);
+        quantized.calibrate(model, data, macro, calibration_rows);
+        QuantizationReport report = compareQuantized(model, quantized, data, macro, report_rows);
+        std::cout << "Int8: " << calibration_rows.size() << " calibration rows, " << report.rows << " compared"
+            << " - Max |dp|: " << report.max_prob_error << " - Mean |dp|: " << report.mean_prob_error
+            << " - Action agreement: " << report.action_agreement
+            << " - Rows/s fp64: " << report.fp64_rows_per_second << " int8: " << report.int8_rows_per_second << std::endl;
+
+        std::vector<double> macro_outputs, combined_output(combined_output_size), probs(PortfolioModel::num_actions);
+        quantized.encode_months(macro, macro_outputs);
+        for (const auto& fd : data) {
+            quantized.encode(fd, macro_outputs, combined_output.data());
+            quantized.action_probs(combined_output.data(), probs.data());
+            long_probs[panel.cell(fd)] = probs[long_action];
+        }
+    }
 
+    printBacktest(panel, long_probs);
+    return 0;
+}
 
-            double advantage = reward;
+// Same on-policy update as the sequential loop in run(), on chunks of a StreamingDataset.
+// Only two chunks are in memory, so there is no price panel and no backtest.
+template <typename Reward>
+int runStreaming(const std::string& path, const Reward& reward_fn, const RunOptions& options) {
+    StreamingDataset stream(path, options.streaming);
+    if (!stream.ok()) {
+        return 1;
+    }
+    std::cout << "Streaming: " << stream.num_rows() << " rows, " << stream.symbols().size() << " symbols, "
+        << stream.macro().size() << " months, chunks of " << options.streaming.chunk_rows << " rows" << std::endl;
+
+    const Hyperparameters& params = options.params;
+    PortfolioModel model(params.num_units_macro, params.num_units_accounting, params.num_units_market);
+    for (LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+        cell->ode_solver_unfolds = params.ode_solver_unfolds;
+        cell->solver = params.solver;
+        cell->adaptive = params.ode;
+    }
+    model.repack();
+    AdamOptimizer adam(params.learning_rate, params.beta1, params.beta2, 1e-8);
+    adam.initialize(model.final_layer.weights, model.final_layer.biases);
+    ExplorationPolicy policy(options.policy, params.epsilon);
+
+    const int long_action = 0;
+    policy.hold_action = long_action;
+    const size_t width = model.combined_output_size();
+    const size_t A = PortfolioModel::num_actions;
+    // chunks arrive in file order (by symbol, then date) and only their rows are shuffled, so
+    // stateful rewards are scored chunk by chunk in file order, the states carried across
+    Reward reward_of_row = reward_fn;
+    DateOrderRewards<Reward> series(stream.symbols().size(), reward_fn);
+    std::vector<double> macro_outputs;
+    Arena& arena = threadArena();
+    model.encode_months(stream.macro(), macro_outputs);
+
+    for (int epoch = 0; epoch < params.epochs; ++epoch) {
+        series.reset();
+        auto start = std::chrono::steady_clock::now();
+        double total = 0.0;
+        size_t rows = 0;
+        stream.start_epoch();
+        while (const StreamChunk* chunk = stream.next_chunk()) {
+            if constexpr (Reward::stateful) {
+                series.clear();
+                for (size_t row = 0; row < chunk->rows.size(); ++row) {
+                    ArenaScope step(arena);
+                    StepScratch s = model.step_scratch(arena);
+                    model.encode(chunk->rows[row], macro_outputs, s.combined_output);
+                    model.action_probs(s.combined_output, s.action_probs);
+                    series.add(row, chunk->symbols[row], chunk->rows[row], s.action_probs[long_action]);
+                }
+                series.evaluate();
+            }
+            // windows of the chunk's shuffled order: scored, one select_actions call, then updates
+            for (size_t first = 0; first < chunk->order.size(); first += selectionWindow) {
+                const size_t n = std::min(selectionWindow, chunk->order.size() - first);
+                ArenaScope step(arena);
+                double* outputs = arena.allocate_array<double>(n * width);
+                double* probs = arena.allocate_array<double>(n * A);
+                int* actions = arena.allocate_array<int>(n);
+                model.score_rows(n, [&](size_t i) -> const FinancialData& {
+                        chunk->order.prefetch(chunk->rows, first + i);
+                        return chunk->rows[chunk->order[first + i]];
+                    }, macro_outputs, outputs, probs);
+                policy.select_actions(probs, n, A, actions);
+
+                StepScratch s = model.step_scratch(arena);
+                for (size_t i = 0; i < n; ++i) {
+                    size_t row = chunk->order[first + i];
+                    const FinancialData& fd = chunk->rows[row];
+                    s.combined_output = outputs + i * width;
+                    s.action_probs = probs + i * A;
+                    double reward = Reward::stateful ? series[row] : reward_of_row(fd, s.action_probs[long_action]);
+                    total += reward;
+                    model.policy_update(s, actions[i], reward, adam, epoch + 1);
+                }
+            }
+            rows += chunk->rows.size();
+        }
+        policy.decay_epsilon(params.epsilon_decay);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Epoch: " << epoch << " - Rows: " << rows << " - Avg Reward: " << (rows ? total / rows : 0.0)
+            << " - Rows/s: " << (seconds > 0.0 ? rows / seconds : 0.0) << std::endl;
+        reportOdeStats(model, params);
+        PROFILE_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
+        ALLOCATION_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
+    }
+    return 0;
+}
 
-            std::vector<double> grad_output(action_probs.size(), 0.0);
-            for (size_t i = 0; i < grad_output.size(); ++i) {
-                if (i == action) {
-                    grad_output[i] = -advantage * (1 - action_probs[i]);
+// Data-parallel training, one process per rank: every rank loads the same file and trains on
+// the symbols whose index % world == rank. One synchronous step per month: the head gradient
+// summed over the month's rows of every rank (ring allreduce), divided by the row count, then
+// the same Adam update on every rank. Only the head is trained; the LTC cells come from
+// rank 0 once, so the replicas start identical and stay identical. With overlap the
+// allreduce of month m runs while month m + 1 is computed and lands one month late.
+template <typename Reward>
+int runDistributed(const std::vector<FinancialData>& data, const std::vector<MacroData>& macro, const PricePanel& panel,
+    const Reward& reward_fn, const RunOptions& options) {
+    const DistributedConfig& config = options.distributed_config;
+    RingCommunicator comm(config);
+    if (!comm.ok()) {
+        return 1;
+    }
+    const bool root = comm.rank() == 0;
+    const Hyperparameters& params = options.params;
+    const int A = PortfolioModel::num_actions;
+    const int long_action = 0;
+
+    try {
+        PortfolioModel model(params.num_units_macro, params.num_units_accounting, params.num_units_market);
+        for (LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+            cell->ode_solver_unfolds = params.ode_solver_unfolds;
+        }
+        std::string bytes;
+        if (root) {
+            std::ostringstream out;
+            writeModel(out, model);
+            bytes = out.str();
+        }
+        comm.broadcast(bytes);
+        std::istringstream in(bytes);
+        if (!readModel(in, model, "rank 0")) {
+            return 1;
+        }
+        for (LTCCell* cell : { &model.ltc_macro, &model.ltc_accounting, &model.ltc_market }) {
+            cell->solver = params.solver;
+            cell->adaptive = params.ode;
+        }
+        model.repack();
+
+        std::vector<std::vector<size_t>> month_rows(panel.num_periods());
+        size_t shard_rows = 0;
+        for (size_t r = 0; r < data.size(); ++r) {
+            if (panel.symbol_index.at(data[r].symbol) % config.world == static_cast<size_t>(config.rank)) {
+                month_rows[data[r].period].push_back(r);
+                ++shard_rows;
+            }
+        }
+        std::cout << "Rank " << config.rank << " of " << config.world << ": " << shard_rows << " rows" << std::endl;
+
+        AdamOptimizer adam(params.learning_rate, params.beta1, params.beta2, 1e-8);
+        adam.initialize(model.final_layer.weights, model.final_layer.biases);
+        ExplorationPolicy policy(options.policy, params.epsilon);
+        policy.hold_action = long_action;
+        std::vector<Reward> rewards(panel.num_symbols(), reward_fn);
+        std::vector<double> macro_outputs;
+        model.encode_months(macro, macro_outputs);
+        Arena& arena = threadArena();
+
+        // [dW | dB] with the configured compression and [reward sum, rows] exact, two of each
+        // for overlap
+        const size_t weights = static_cast<size_t>(A) * model.combined_output_size();
+        std::vector<std::vector<double>> gradients(2, std::vector<double>(weights + A));
+        std::vector<std::vector<double>> totals(2, std::vector<double>(2));
+        auto allreduce = [&comm, &gradients, &totals](size_t b) {
+            comm.allreduce(gradients[b]);
+            comm.allreduce(totals[b].data(), totals[b].size(), GradientCompression::None);
+        };
+        PendingAllreduce pending;
+
+        for (int epoch = 0; epoch < params.epochs; ++epoch) {
+            for (auto& r : rewards) {
+                r.reset();
+            }
+            auto start = std::chrono::steady_clock::now();
+            CommStats before = comm.stats();
+            double total = 0.0, rows = 0.0;
+            auto apply = [&](size_t b) {
+                std::vector<double>& g = gradients[b];
+                double n = totals[b][1];
+                total += totals[b][0];
+                rows += n;
+                if (n == 0.0) return;
+                for (double& x : g) x /= n;
+                adam.update(model.final_layer.weights, model.final_layer.biases, g.data(), g.data() + weights, epoch + 1);
+            };
+
+            for (size_t m = 0; m < month_rows.size(); ++m) {
+                const size_t b = m % 2;
+                std::vector<double>& g = gradients[b];
+                std::fill(g.begin(), g.end(), 0.0);
+                std::fill(totals[b].begin(), totals[b].end(), 0.0);
+
+                // the month's symbols are scored first, then one call selects all their actions
+                const std::vector<size_t>& rows_of_month = month_rows[m];
+                const size_t n = rows_of_month.size();
+                const size_t width = model.combined_output_size();
+                ArenaScope month(arena);
+                double* outputs = arena.allocate_array<double>(n * width);
+                double* probs = arena.allocate_array<double>(n * A);
+                int* actions = arena.allocate_array<int>(n);
+                for (size_t i = 0; i < n; ++i) {
+                    model.encode(data[rows_of_month[i]], macro_outputs, outputs + i * width);
+                    model.action_probs(outputs + i * width, probs + i * A);
+                }
+                policy.select_actions(probs, n, A, actions);
+
+                StepScratch s = model.step_scratch(arena);
+                for (size_t i = 0; i < n; ++i) {
+                    const FinancialData& fd = data[rows_of_month[i]];
+                    s.combined_output = outputs + i * width;
+                    s.action_probs = probs + i * A;
+                    double reward = rewards[panel.symbol_index.at(fd.symbol)](fd, s.action_probs[long_action]);
+                    model.accumulate_policy_gradient(s, actions[i], reward, g.data(), g.data() + weights);
+                    totals[b][0] += reward;
+                    totals[b][1] += 1.0;
+                }
+                if (config.overlap) {
+                    if (pending.wait()) apply(1 - b);
+                    pending.start([&allreduce, b] { allreduce(b); });
                 }
                 else {
-                    grad_output[i] = advantage * action_probs[i];
+                    allreduce(b);
+                    apply(b);
                 }
             }
-
-            // backprop
-            std::vector<std::vector<double>> dW;
-            std::vector<double> dB;
-            final_layer.backward(combined_output, grad_output, dW, dB);
-            adam.update(final_layer.weights, final_layer.biases, dW, dB, epoch + 1);
+            if (pending.wait()) apply((month_rows.size() + 1) % 2);
+            policy.decay_epsilon(params.epsilon_decay);
+
+            if (root) {
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                const CommStats& after = comm.stats();
+                std::cout << "Epoch: " << epoch << " - Rows: " << rows << " - Avg Reward: " << (rows > 0.0 ? total / rows : 0.0)
+                    << " - Allreduces: " << after.allreduces - before.allreduces
+                    << " - Sent: " << (after.bytes_sent - before.bytes_sent) / 1e6 << " MB"
+                    << " - Comm: " << after.seconds - before.seconds << " s of " << seconds << " s" << std::endl;
+                reportOdeStats(model, params);
+                PROFILE_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
+                ALLOCATION_SUMMARY(std::cout, "Epoch " + std::to_string(epoch));
+            }
         }
 
+        // every rank compares its model with rank 0's
+        std::ostringstream out;
+        writeModel(out, model);
+        std::string own = out.str();
+        bytes = own;
+        comm.broadcast(bytes);
+        double differing = bytes == own ? 0.0 : 1.0;
+        comm.allreduce(&differing, 1, GradientCompression::None);
+        if (!root) {
+            return 0;
+        }
+        std::cout << "Replicas: " << config.world - std::lround(differing) << " of " << config.world << " identical to rank 0" << std::endl;
 
-        policy.decay_epsilon(epsilon_decay);
-
+        if (!options.save_model.empty() && saveModel(options.save_model, model)) {
+            std::cout << "Model saved: " << options.save_model << std::endl;
+        }
+        std::vector<double> long_probs(panel.prices.size(), 0.0);
+        std::vector<double> combined_output(model.combined_output_size()), probs(A);
+        for (const auto& fd : data) {
+            model.encode(fd, macro_outputs, combined_output.data());
+            model.action_probs(combined_output.data(), probs.data());
+            long_probs[panel.cell(fd)] = probs[long_action];
+        }
+        printBacktest(panel, long_probs);
+    }
+    catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
-        if (epoch % 1 == 0) {
-            std::cout << "Epoch: " << epoch << std::endl;
-            for (const auto& pair : cumulative_rewards) {
-                const std::string& symbol = pair.first;
-                double reward = pair.second;
-                std::cout << "Symbol: " << symbol << " - Cumulative Reward: " << reward << std::endl;
+int main(int argc, char** argv) {
+    RewardKind reward_kind = RewardKind::CubedReturn;
+    RunOptions options;
+    std::string trace_path;  // Chrome trace, PORTFOLIO_PROFILE builds only
+    std::string data_path = "financial_data.csv";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--reward=", 0) == 0 && !parseRewardKind(arg.substr(9), reward_kind)) {
+            std::cerr << "Unknown reward: " << arg.substr(9) << " (cubed, log, sharpe, drawdown, turnover)" << std::endl;
+            return 1;
+        }
+        if (arg.rfind("--policy=", 0) == 0 && !parsePolicyKind(arg.substr(9), options.policy)) {
+            std::cerr << "Unknown policy: " << arg.substr(9) << " (epsilon, boltzmann, gumbel, dirichlet)" << std::endl;
+            return 1;
+        }
+        if (arg.rfind("--replay=", 0) == 0) {
+            options.replay_batch = std::stoul(arg.substr(9));
+        }
+        if (arg.rfind("--actors=", 0) == 0) {
+            options.actors = std::stoi(arg.substr(9));
+        }
+        if (arg.rfind("--search=", 0) == 0) {
+            if (!parseSearchMethod(arg.substr(9), options.search_options.method)) {
+                std::cerr << "Unknown search: " << arg.substr(9) << " (random, halving, hyperband)" << std::endl;
+                return 1;
+            }
+            options.search = true;
+        }
+        if (arg.rfind("--trials=", 0) == 0) {
+            options.search_options.num_trials = std::stoi(arg.substr(9));
+        }
+        if (arg.rfind("--max-epochs=", 0) == 0) {
+            options.search_options.max_epochs = std::stoi(arg.substr(13));
+        }
+        if (arg.rfind("--budget=", 0) == 0) {
+            options.search_options.epoch_budget = std::stoul(arg.substr(9));
+        }
+        if (arg.rfind("--threads=", 0) == 0) {
+            options.search_options.threads = std::stoi(arg.substr(10));
+            options.walk_forward_config.threads = options.search_options.threads;
+            ThreadPool::configure(options.search_options.threads);
+        }
+        if (arg.rfind("--ode=", 0) == 0) {
+            if (arg.substr(6) != "adaptive" && arg.substr(6) != "fixed") {
+                std::cerr << "Unknown ODE solver: " << arg.substr(6) << " (fixed, adaptive)" << std::endl;
+                return 1;
             }
+            options.params.solver = arg.substr(6) == "adaptive" ? ODESolver::Adaptive : ODESolver::SemiImplicit;
+        }
+        if (arg.rfind("--ode-rtol=", 0) == 0) {
+            options.params.ode.rtol = std::stod(arg.substr(11));
+        }
+        if (arg.rfind("--ode-exit=", 0) == 0) {
+            options.params.ode.exit_tolerance = std::stod(arg.substr(11));
+        }
+        if (arg.rfind("--world=", 0) == 0) {
+            options.distributed = true;
+            options.distributed_config.world = std::stoi(arg.substr(8));
+        }
+        if (arg.rfind("--rank=", 0) == 0) {
+            options.distributed_config.rank = std::stoi(arg.substr(7));
+        }
+        if (arg.rfind("--transport=", 0) == 0) {
+            options.distributed_config.transport = arg.substr(12);
+        }
+        if (arg.rfind("--compress=", 0) == 0 && !parseGradientCompression(arg.substr(11), options.distributed_config.compression)) {
+            std::cerr << "Unknown compression: " << arg.substr(11) << " (none, fp32, int8)" << std::endl;
+            return 1;
+        }
+        if (arg == "--overlap") {
+            options.distributed_config.overlap = true;
+        }
+        if (arg == "--walk-forward") {
+            options.walk_forward = true;
+        }
+        if (arg.rfind("--test-months=", 0) == 0) {
+            options.walk_forward_config.test_periods = std::stoi(arg.substr(14));
+        }
+        if (arg.rfind("--min-train-months=", 0) == 0) {
+            options.walk_forward_config.min_train_periods = std::stoi(arg.substr(19));
+        }
+        if (arg.rfind("--window-months=", 0) == 0) {
+            options.walk_forward_config.window_periods = std::stoi(arg.substr(16));
+        }
+        if (arg.rfind("--shuffle-block=", 0) == 0) {
+            options.shuffle_block = std::stoul(arg.substr(16));
+            options.search_options.shuffle_block = options.shuffle_block;
+            options.streaming.shuffle_block = options.shuffle_block;
+        }
+        if (arg == "--quantize") {
+            options.quantize = true;
+        }
+        if (arg.rfind("--save-model=", 0) == 0) {
+            options.save_model = arg.substr(13);
+        }
+        if (arg == "--stream") {
+            options.stream = true;
+        }
+        if (arg.rfind("--chunk-rows=", 0) == 0) {
+            options.streaming.chunk_rows = std::stoul(arg.substr(13));
+        }
+        if (arg.rfind("--data=", 0) == 0) {
+            data_path = arg.substr(7);
+        }
+        if (arg.rfind("--trace=", 0) == 0) {
+            trace_path = arg.substr(8);
+        }
+        if (arg == "--mode=cross") {
+            options.cross_asset = true;
+        }
+    }
+    // QuantizedLTC runs the fixed unfolds only
+    if (options.quantize && options.params.solver == ODESolver::Adaptive) {
+        std::cerr << "--quantize scores with fixed unfolds: use it with --ode=fixed" << std::endl;
+        return 1;
+    }
+    options.search_options.space.solver = options.params.solver;
+    options.search_options.space.ode = options.params.ode;
+
+    // out-of-core: no loading, the dataset reads the file once per epoch
+    if (options.stream) {
+        int status = withReward(reward_kind, [&](auto reward_fn) {
+            return runStreaming(data_path, reward_fn, options);
+        });
+        if (!trace_path.empty()) {
+            PROFILE_WRITE_TRACE(trace_path);
+        }
+        return status;
+    }
 
+    std::vector<MacroData> macro;
+    // .bin = BinaryDataset.h format (generate --binary=...)
+    bool binary = data_path.size() > 4 && data_path.compare(data_path.size() - 4, 4, ".bin") == 0;
+    DataValidity validity;
+    std::vector<FinancialData> data = binary ? loadFinancialDataBinary(data_path, macro, validity) : loadFinancialData(data_path, macro, validity);
+    ImputationStats imputation = imputeMissing(data, macro, validity);
+    if (imputation.missing) {
+        std::cout << "Missing: " << imputation.missing << " - Forward-filled: " << imputation.forward_filled
+            << " - Median-filled: " << imputation.median_filled << " - Unfilled: " << imputation.unfilled << std::endl;
+    }
 
+    // raw prices, normalizeData overwrites them
+    PricePanel panel = buildPricePanel(data);
 
-        }
+    // walk-forward folds normalize with their own training-window statistics
+    if (!options.walk_forward) {
+        normalizeData(data, macro, validity);
     }
-
-    return 0;
+    PROFILE_SUMMARY(std::cout, "Load");
+    ALLOCATION_SUMMARY(std::cout, "Load");
+
+    int status = withReward(reward_kind, [&](auto reward_fn) {
+        return options.distributed ? runDistributed(data, macro, panel, reward_fn, options) : run(data, macro, validity, panel, reward_fn, options);
+    });
+    if (!trace_path.empty()) {
+        PROFILE_WRITE_TRACE(trace_path);
+    }
+    return status;
 }
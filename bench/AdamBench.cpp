@@ -0,0 +1,22 @@
+// Adam update bandwidth: per parameter w, m, v are read and written and dW is read
+#include "Bench.h"
+#include "AdamOptimizer.h"
+
+static void BM_AdamUpdate(benchmark::State& state) {
+    const size_t rows = state.range(0), cols = state.range(1);
+    std::vector<std::vector<double>> W(rows, std::vector<double>(cols, 0.1));
+    std::vector<std::vector<double>> dW(rows, std::vector<double>(cols, 0.01));
+    std::vector<double> b(rows, 0.0), dB(rows, 0.01);
+    AdamOptimizer adam(0.001, 0.9, 0.999, 1e-8);
+    adam.initialize(W, b);
+    int t = 1;
+    for (auto _ : state) {
+        adam.update(W, b, dW, dB, t++);
+        benchmark::ClobberMemory();
+    }
+    const int64_t parameters = rows * cols + rows;
+    state.SetBytesProcessed(state.iterations() * parameters * 7 * sizeof(double));
+    state.SetItemsProcessed(state.iterations() * parameters);
+}
+// 2 x 15 is the default dense head
+BENCHMARK(BM_AdamUpdate)->Args({ 2, 15 })->Args({ 64, 64 })->Args({ 512, 512 })->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,84 @@
+// Scoring with the engine (arg 1 = 0) and with the scorer compile_model generated for the
+// same model (1); arg 0 picks the build-time reference model (0 = ref_a 5/5/5 units, 6
+// unfolds, 1 = ref_b 3/8/4 units, 2 unfolds). Every row is checked bit for bit first.
+#include "Bench.h"
+#include "BenchData.h"
+#include "BinaryDataset.h"
+#include "DataPreprocessing.h"
+#include "ModelFile.h"
+#include "ref_a.h"
+#include "ref_b.h"
+#include <cstring>
+#include <string>
+
+template <void (*EncodeMonth)(double*), void (*Score)(const double*, double*)>
+static double scoreCompiled(const std::vector<FinancialData>& data, size_t months, size_t macro_units,
+    std::vector<double>& macro_outputs, std::vector<double>& probs) {
+    macro_outputs.resize(months * macro_units);
+    for (size_t t = 0; t < months; ++t) {
+        EncodeMonth(&macro_outputs[t * macro_units]);
+    }
+    double sum = 0.0;
+    for (const auto& fd : data) {
+        Score(&macro_outputs[fd.period * macro_units], probs.data());
+        sum += probs[0];
+    }
+    return sum;
+}
+
+static void BM_AotScore(benchmark::State& state) {
+    BenchDataset files(200, 10, false, true);
+    std::vector<MacroData> macro;
+    std::vector<FinancialData> data = loadFinancialDataBinary(files.binary_path, macro);
+    normalizeData(data, macro);
+    const bool first = state.range(0) == 0;
+    const bool compiled = state.range(1) == 1;
+
+    PortfolioModel model(1, 1, 1);
+    if (!loadModel(std::string(PORTFOLIO_AOT_DIR) + (first ? "/ref_a.bin" : "/ref_b.bin"), model)) {
+        state.SkipWithError("reference model missing");
+        return;
+    }
+    const size_t macro_units = model.ltc_macro.num_units;
+    auto score = [&](std::vector<double>& macro_outputs, std::vector<double>& probs) {
+        return first ? scoreCompiled<ref_a::encode_month, ref_a::score>(data, macro.size(), macro_units, macro_outputs, probs)
+                     : scoreCompiled<ref_b::encode_month, ref_b::score>(data, macro.size(), macro_units, macro_outputs, probs);
+    };
+
+    // generated scorer == engine, bit for bit, on every row
+    std::vector<double> macro_outputs, compiled_outputs, combined_output(model.combined_output_size());
+    std::vector<double> probs(PortfolioModel::num_actions), compiled_probs(PortfolioModel::num_actions);
+    model.encode_months(macro, macro_outputs);
+    score(compiled_outputs, compiled_probs);
+    if (std::memcmp(macro_outputs.data(), compiled_outputs.data(), macro_outputs.size() * sizeof(double)) != 0) {
+        state.SkipWithError("compiled encode_month differs from the engine");
+        return;
+    }
+    for (const auto& fd : data) {
+        model.encode(fd, macro_outputs, combined_output.data());
+        model.action_probs(combined_output.data(), probs.data());
+        (first ? ref_a::score : ref_b::score)(&macro_outputs[fd.period * macro_units], compiled_probs.data());
+        if (std::memcmp(probs.data(), compiled_probs.data(), probs.size() * sizeof(double)) != 0) {
+            state.SkipWithError("compiled score differs from the engine");
+            return;
+        }
+    }
+
+    for (auto _ : state) {
+        double sum = 0.0;
+        if (compiled) {
+            sum = score(compiled_outputs, probs);
+        }
+        else {
+            model.encode_months(macro, macro_outputs);
+            for (const auto& fd : data) {
+                model.encode(fd, macro_outputs, combined_output.data());
+                model.action_probs(combined_output.data(), probs.data());
+                sum += probs[0];
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_AotScore)->ArgsProduct({ { 0, 1 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,248 @@
+#pragma once
+// Benchmarks are written against the Google Benchmark API. When the library is found
+// (PORTFOLIO_HAVE_GBENCH) it is used as-is, otherwise the subset below stands in for it:
+// State with range()/iterations()/Set*Processed()/Pause|ResumeTiming()/SkipWithError()/counters,
+// BENCHMARK(fn)->Arg/Args/ArgsProduct/Unit, DoNotOptimize, ClobberMemory and
+// BENCHMARK_MAIN, plus the --benchmark_filter and --benchmark_min_time flags.
+
+#ifdef PORTFOLIO_HAVE_GBENCH
+
+#include <benchmark/benchmark.h>
+
+#else
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+enum TimeUnit { kNanosecond, kMicrosecond, kMillisecond };
+
+template <typename T>
+inline void DoNotOptimize(T&& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+inline void ClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+class State {
+public:
+    std::map<std::string, double> counters;
+
+    State(int64_t max_iterations, const std::vector<int64_t>& args) : max_iterations(max_iterations), args(args) {}
+
+    struct Iterator {
+        State* state;
+        int64_t left;
+
+        bool operator!=(const Iterator&) {
+            if (left > 0) return true;
+            state->stop();
+            return false;
+        }
+        Iterator& operator++() {
+            --left;
+            return *this;
+        }
+        int operator*() const { return 0; }
+    };
+
+    // no iterations once SkipWithError was called
+    Iterator begin() {
+        start();
+        return { this, error.empty() ? max_iterations : 0 };
+    }
+    Iterator end() { return { this, 0 }; }
+
+    int64_t range(size_t i = 0) const { return args.at(i); }
+    int64_t iterations() const { return max_iterations; }
+
+    void PauseTiming() { elapsed += seconds_since(started); }
+    void ResumeTiming() { started = clock::now(); }
+
+    void SetBytesProcessed(int64_t bytes) { bytes_processed = bytes; }
+    void SetItemsProcessed(int64_t items) { items_processed = items; }
+    void SetLabel(const std::string& text) { label = text; }
+    void SkipWithError(const std::string& message) { error = message; }
+
+    double seconds() const { return elapsed; }
+    int64_t bytes() const { return bytes_processed; }
+    int64_t items() const { return items_processed; }
+    const std::string& get_label() const { return label; }
+    const std::string& get_error() const { return error; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    int64_t max_iterations;
+    std::vector<int64_t> args;
+    clock::time_point started;
+    double elapsed = 0.0;
+    int64_t bytes_processed = 0;
+    int64_t items_processed = 0;
+    std::string label;
+    std::string error;
+
+    static double seconds_since(clock::time_point t) {
+        return std::chrono::duration<double>(clock::now() - t).count();
+    }
+    void start() {
+        elapsed = 0.0;
+        started = clock::now();
+    }
+    void stop() { elapsed += seconds_since(started); }
+};
+
+namespace internal {
+
+class Benchmark {
+public:
+    Benchmark(const char* name, void (*fn)(State&)) : name(name), fn(fn) {}
+
+    Benchmark* Arg(int64_t x) { return Args({ x }); }
+    Benchmark* Args(const std::vector<int64_t>& args) {
+        arg_sets.push_back(args);
+        return this;
+    }
+    // cartesian product, first list varies fastest
+    Benchmark* ArgsProduct(const std::vector<std::vector<int64_t>>& lists) {
+        std::vector<size_t> index(lists.size(), 0);
+        while (true) {
+            std::vector<int64_t> args;
+            for (size_t i = 0; i < lists.size(); ++i) args.push_back(lists[i][index[i]]);
+            arg_sets.push_back(args);
+            size_t i = 0;
+            while (i < lists.size() && ++index[i] == lists[i].size()) index[i++] = 0;
+            if (i == lists.size()) return this;
+        }
+    }
+    Benchmark* Unit(TimeUnit u) {
+        unit = u;
+        return this;
+    }
+
+    std::string name;
+    void (*fn)(State&);
+    std::vector<std::vector<int64_t>> arg_sets;
+    TimeUnit unit = kNanosecond;
+};
+
+inline std::vector<std::unique_ptr<Benchmark>>& registry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark* RegisterBenchmarkInternal(Benchmark* benchmark) {
+    registry().emplace_back(benchmark);
+    return benchmark;
+}
+
+struct Flags {
+    std::string filter = ".";
+    double min_time = 0.5;  // seconds per measurement
+};
+
+inline Flags& flags() {
+    static Flags f;
+    return f;
+}
+
+inline std::string format_rate(double per_second, const char* suffix) {
+    const char* prefixes[] = { "", "k", "M", "G", "T" };
+    int p = 0;
+    while (per_second >= 1000.0 && p < 4) {
+        per_second /= 1000.0;
+        ++p;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << per_second << prefixes[p] << suffix;
+    return out.str();
+}
+
+// iterations grow until one run lasts min_time, like the real library
+inline void run(const Benchmark& benchmark, const std::vector<int64_t>& args, const std::string& name) {
+    int64_t iterations = 1;
+    while (true) {
+        State state(iterations, args);
+        benchmark.fn(state);
+        double seconds = state.seconds();
+        if (!state.get_error().empty()) {
+            std::cout << std::left << std::setw(44) << name << std::right << " ERROR: " << state.get_error() << std::endl;
+            return;
+        }
+        if (seconds >= flags().min_time || iterations >= 1000000000) {
+            static const double scale[] = { 1e9, 1e6, 1e3 };
+            static const char* unit_name[] = { "ns", "us", "ms" };
+            std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1)
+                << std::setw(14) << seconds / iterations * scale[benchmark.unit] << " " << unit_name[benchmark.unit]
+                << std::setw(12) << iterations;
+            if (state.bytes() > 0) std::cout << "  bytes_per_second=" << format_rate(state.bytes() / seconds, "B/s");
+            if (state.items() > 0) std::cout << "  items_per_second=" << format_rate(state.items() / seconds, "/s");
+            for (const auto& counter : state.counters) {
+                std::cout << "  " << counter.first << "=" << std::defaultfloat << std::setprecision(6) << counter.second;
+            }
+            if (!state.get_label().empty()) std::cout << "  " << state.get_label();
+            std::cout << std::defaultfloat << std::endl;
+            return;
+        }
+        double grow = seconds > 0.0 ? 1.4 * flags().min_time / seconds : 100.0;
+        iterations = static_cast<int64_t>(iterations * std::min(100.0, std::max(2.0, grow)));
+    }
+}
+
+} // namespace internal
+
+inline void Initialize(int* argc, char** argv) {
+    for (int i = 1; i < *argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--benchmark_filter=", 0) == 0) internal::flags().filter = arg.substr(19);
+        if (arg.rfind("--benchmark_min_time=", 0) == 0) internal::flags().min_time = std::stod(arg.substr(21));
+    }
+}
+
+inline size_t RunSpecifiedBenchmarks() {
+    std::regex filter(internal::flags().filter);
+    size_t count = 0;
+    std::cout << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(17) << "Time"
+        << std::setw(12) << "Iterations" << std::endl;
+    std::cout << std::string(73, '-') << std::endl;
+    for (const auto& benchmark : internal::registry()) {
+        std::vector<std::vector<int64_t>> arg_sets = benchmark->arg_sets;
+        if (arg_sets.empty()) arg_sets.emplace_back();
+        for (const auto& args : arg_sets) {
+            std::string name = benchmark->name;
+            for (int64_t a : args) name += "/" + std::to_string(a);
+            if (!std::regex_search(name, filter)) continue;
+            internal::run(*benchmark, args, name);
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace benchmark
+
+#define BENCHMARK_CONCAT_(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_(a, b)
+#define BENCHMARK(fn) \
+    static ::benchmark::internal::Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) = \
+        ::benchmark::internal::RegisterBenchmarkInternal(new ::benchmark::internal::Benchmark(#fn, fn))
+#define BENCHMARK_MAIN() \
+    int main(int argc, char** argv) { \
+        ::benchmark::Initialize(&argc, argv); \
+        ::benchmark::RunSpecifiedBenchmarks(); \
+        return 0; \
+    }
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+// Synthetic datasets for the benchmarks, written to the temp directory and removed with the object
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "SyntheticGenerator.h"
+
+struct BenchDataset {
+    std::string csv_path;
+    std::string binary_path;
+    GeneratorStats stats;
+
+    BenchDataset(int num_symbols, int num_years, bool csv, bool binary) {
+        std::string stem = (std::filesystem::temp_directory_path() /
+            ("portfolio_bench_" + std::to_string(num_symbols) + "x" + std::to_string(num_years))).string();
+        GeneratorConfig config;
+        config.num_symbols = num_symbols;
+        config.num_years = num_years;
+        if (csv) config.csv_path = csv_path = stem + ".csv";
+        if (binary) config.binary_path = binary_path = stem + ".bin";
+        generateSyntheticDataset(config, stats);
+    }
+
+    ~BenchDataset() {
+        if (!csv_path.empty()) std::remove(csv_path.c_str());
+        if (!binary_path.empty()) std::remove(binary_path.c_str());
+    }
+
+    BenchDataset(const BenchDataset&) = delete;
+    BenchDataset& operator=(const BenchDataset&) = delete;
+};
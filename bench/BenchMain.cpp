@@ -0,0 +1,3 @@
+#include "Bench.h"
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+// Dataset generation, CSV / binary load and normalization throughput; args are symbols, years
+#include "Bench.h"
+#include "BenchData.h"
+#include "BinaryDataset.h"
+#include "CSVReader.h"
+#include "DataPreprocessing.h"
+#include "ExplorationPolicy.h"
+
+static void BM_GenerateDataset(benchmark::State& state) {
+    const int symbols = static_cast<int>(state.range(0)), years = static_cast<int>(state.range(1));
+    uint64_t bytes = 0;
+    for (auto _ : state) {
+        BenchDataset dataset(symbols, years, true, true);
+        bytes = dataset.stats.csv_bytes + dataset.stats.binary_bytes;
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(symbols) * years * 12);
+}
+BENCHMARK(BM_GenerateDataset)->Args({ 1000, 10 })->Unit(benchmark::kMillisecond);
+
+static void BM_LoadCSV(benchmark::State& state) {
+    BenchDataset dataset(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), true, false);
+    size_t rows = 0;
+    for (auto _ : state) {
+        std::vector<MacroData> macro;
+        std::vector<FinancialData> data = loadFinancialData(dataset.csv_path, macro);
+        rows = data.size();
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.iterations() * dataset.stats.csv_bytes);
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_LoadCSV)->Args({ 100, 10 })->Args({ 1000, 10 })->Unit(benchmark::kMillisecond);
+
+static void BM_LoadBinary(benchmark::State& state) {
+    BenchDataset dataset(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    size_t rows = 0;
+    for (auto _ : state) {
+        std::vector<MacroData> macro;
+        std::vector<FinancialData> data = loadFinancialDataBinary(dataset.binary_path, macro);
+        rows = data.size();
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.iterations() * dataset.stats.binary_bytes);
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_LoadBinary)->Args({ 100, 10 })->Args({ 1000, 10 })->Unit(benchmark::kMillisecond);
+
+// items = normalized values (rows x row attributes + months x macro attributes)
+static void BM_NormalizeData(benchmark::State& state) {
+    BenchDataset dataset(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    std::vector<MacroData> raw_macro;
+    const std::vector<FinancialData> raw = loadFinancialDataBinary(dataset.binary_path, raw_macro);
+
+    size_t row_fields = 0;
+    for (const FeatureField& field : featureSchema) row_fields += field.row != nullptr;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<FinancialData> data = raw;
+        std::vector<MacroData> macro = raw_macro;
+        state.ResumeTiming();
+        normalizeData(data, macro);
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetItemsProcessed(state.iterations() * (raw.size() * row_fields + raw_macro.size() * (featureSchemaSize - row_fields)));
+}
+BENCHMARK(BM_NormalizeData)->Args({ 100, 10 })->Args({ 1000, 10 })->Unit(benchmark::kMillisecond);
+
+// Statistics of every walk-forward training window (expanding, 12-month step): arg 2 = 0
+// recomputes them with a pass over each window, 1 reads them from NormalizationMoments
+static void BM_FoldStatistics(benchmark::State& state) {
+    BenchDataset dataset(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    std::vector<MacroData> raw_macro;
+    const std::vector<FinancialData> raw = loadFinancialDataBinary(dataset.binary_path, raw_macro);
+    const bool cached = state.range(2) != 0;
+    const int periods = static_cast<int>(raw_macro.size());
+
+    int folds = 0;
+    for (auto _ : state) {
+        folds = 0;
+        if (cached) {
+            NormalizationMoments moments(raw, raw_macro);
+            for (int split = 12; split < periods; split += 12, ++folds) {
+                NormalizationStats stats = moments.stats(0, split);
+                benchmark::DoNotOptimize(stats);
+            }
+        } else {
+            for (int split = 12; split < periods; split += 12, ++folds) {
+                std::vector<FinancialData> data;
+                for (const auto& fd : raw) {
+                    if (fd.period < split) data.push_back(fd);
+                }
+                std::vector<MacroData> macro(raw_macro.begin(), raw_macro.begin() + split);
+                normalizeData(data, macro);
+                benchmark::DoNotOptimize(data);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * folds);
+}
+BENCHMARK(BM_FoldStatistics)->ArgsProduct({ { 1000 }, { 10 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+// Imputation + mask-aware normalization, 5% of the values missing; items = values
+static void BM_ImputeAndNormalize(benchmark::State& state) {
+    BenchDataset dataset(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    std::vector<MacroData> raw_macro;
+    DataValidity raw_validity;
+    const std::vector<FinancialData> raw = loadFinancialDataBinary(dataset.binary_path, raw_macro, raw_validity);
+    RngStream rng(7, 0);
+    for (size_t f = 0; f < featureSchemaSize; ++f) {
+        ValidityMask& mask = raw_validity.fields[f];
+        for (size_t i = 0; i < mask.size(); ++i) {
+            if (rng.uniform() < 0.05) mask.reset(i);
+        }
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<FinancialData> data = raw;
+        std::vector<MacroData> macro = raw_macro;
+        DataValidity validity = raw_validity;
+        state.ResumeTiming();
+        imputeMissing(data, macro, validity);
+        normalizeData(data, macro, validity);
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetItemsProcessed(state.iterations() * (raw.size() + raw_macro.size()) * featureSchemaSize);
+}
+BENCHMARK(BM_ImputeAndNormalize)->Args({ 100, 10 })->Args({ 1000, 10 })->Unit(benchmark::kMillisecond);
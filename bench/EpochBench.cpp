@@ -0,0 +1,25 @@
+// Full training epochs (encode, head forward/backward, Adam per row) on synthetic data; args are symbols, years
+#include "Bench.h"
+#include "BenchData.h"
+#include "BinaryDataset.h"
+#include "DataPreprocessing.h"
+#include "Backtest.h"
+#include "RewardFunction.h"
+#include "HyperparameterSearch.h"
+
+static void BM_TrainEpoch(benchmark::State& state) {
+    BenchDataset files(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    std::vector<MacroData> macro;
+    std::vector<FinancialData> data = loadFinancialDataBinary(files.binary_path, macro);
+    PricePanel panel = buildPricePanel(data);
+    normalizeData(data, macro);
+
+    SearchOptions options;
+    SearchDataset dataset(data, macro, panel, 0.0);
+    Trial<CubedReturnReward> trial(0, Hyperparameters(), options, CubedReturnReward(), panel.num_symbols());
+    for (auto _ : state) {
+        trial.train_epoch(dataset);
+    }
+    state.SetItemsProcessed(state.iterations() * dataset.train_rows.size());
+}
+BENCHMARK(BM_TrainEpoch)->Args({ 50, 10 })->Args({ 500, 10 })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,146 @@
+// LTC step latency against units and ODE unfolds: dense cell, fused trio, CSR sparse cell
+// and the density below which CSR beats dense
+#include "Bench.h"
+#include "LTC.h"
+#include "FusedLTC.h"
+#include "SparseLTC.h"
+#include <chrono>
+#include <cmath>
+#include <string>
+
+static void BM_LTCStep(benchmark::State& state) {
+    const int units = static_cast<int>(state.range(0));
+    LTCCell cell(units, 8);
+    cell.ode_solver_unfolds = static_cast<int>(state.range(1));
+    std::vector<double> inputs(8, 0.0);
+    std::vector<double> v(units, 0.1);
+    for (auto _ : state) {
+        std::vector<double> next = cell.ode_step(inputs, v);
+        benchmark::DoNotOptimize(next);
+    }
+    state.SetItemsProcessed(state.iterations() * units * cell.ode_solver_unfolds);
+}
+BENCHMARK(BM_LTCStep)->ArgsProduct({ { 5, 16, 64, 256 }, { 1, 6, 12 } })->Unit(benchmark::kMicrosecond);
+
+// accounting + market packed block-diagonally, as in PortfolioModel::encode
+static void BM_FusedLTCStep(benchmark::State& state) {
+    const int units = static_cast<int>(state.range(0));
+    LTCCell accounting(units, 9), market(units, 8);
+    accounting.ode_solver_unfolds = market.ode_solver_unfolds = static_cast<int>(state.range(1));
+    FusedLTCExecutor fused({ &accounting, &market });
+    std::vector<double> v(fused.total_units, 0.1), out(fused.total_units);
+    for (auto _ : state) {
+        fused.step(v.data(), out.data());
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * fused.total_units * fused.ode_solver_unfolds);
+}
+BENCHMARK(BM_FusedLTCStep)->ArgsProduct({ { 5, 16, 64, 256 }, { 1, 6, 12 } })->Unit(benchmark::kMicrosecond);
+
+// NCP layout over `units`: half inter, 3/8 command, the rest motor; each inter unit feeds 4
+// commands, 2 recurrent synapses per command, each motor reads 6 commands
+static Wiring benchNcpWiring(int units) {
+    const int inter = units / 2, command = units * 3 / 8;
+    return ncpWiring(inter, command, units - inter - command, 4, 2 * command, 6, 7);
+}
+
+// second argument is the wiring density in percent, 0 = NCP wiring; compare with
+// BM_LTCStep/<units>/6
+static void BM_SparseLTCStep(benchmark::State& state) {
+    const int units = static_cast<int>(state.range(0));
+    LTCCell dense(units, 8);
+    SparseLTCCell sparse(dense, state.range(1) == 0 ? benchNcpWiring(units) : randomSparseWiring(units, state.range(1) / 100.0, 7));
+    std::vector<double> inputs(8, 0.0);
+    std::vector<double> v(units, 0.1);
+    for (auto _ : state) {
+        std::vector<double> next = sparse.ode_step(inputs, v);
+        benchmark::DoNotOptimize(next);
+    }
+    state.counters["edges"] = static_cast<double>(sparse.num_edges());
+    state.SetItemsProcessed(state.iterations() * sparse.num_edges() * sparse.ode_solver_unfolds);
+}
+BENCHMARK(BM_SparseLTCStep)->ArgsProduct({ { 64, 256 }, { 0, 1, 5, 10, 30, 100 } })->Unit(benchmark::kMicrosecond);
+
+// Dense vs CSR crossover for one unit count: every iteration runs one ode_step of the dense
+// cell and of a sparse cell per density, each timed on its own. crossover_density is where
+// the sparse time, interpolated between the measured densities, reaches the dense time:
+// below it the CSR cell is faster (1 = faster even fully connected). The NCP wiring of the
+// same units is timed alongside: ncp_density is its edge count over units^2.
+static void BM_SparseCrossover(benchmark::State& state) {
+    using clock = std::chrono::steady_clock;
+    const int units = static_cast<int>(state.range(0));
+    const std::vector<double> densities = { 0.01, 0.02, 0.05, 0.1, 0.2, 0.3, 0.5, 1.0 };
+    LTCCell dense(units, 8);
+    std::vector<SparseLTCCell> sparse;
+    for (double density : densities) {
+        sparse.emplace_back(dense, randomSparseWiring(units, density, 7));
+    }
+    SparseLTCCell ncp(dense, benchNcpWiring(units));
+    std::vector<double> inputs(8, 0.0);
+    std::vector<double> v(units, 0.1);
+
+    double dense_seconds = 0.0, ncp_seconds = 0.0;
+    std::vector<double> sparse_seconds(densities.size(), 0.0);
+    for (auto _ : state) {
+        auto start = clock::now();
+        std::vector<double> next = dense.ode_step(inputs, v);
+        benchmark::DoNotOptimize(next);
+        dense_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        for (size_t d = 0; d < sparse.size(); ++d) {
+            start = clock::now();
+            next = sparse[d].ode_step(inputs, v);
+            benchmark::DoNotOptimize(next);
+            sparse_seconds[d] += std::chrono::duration<double>(clock::now() - start).count();
+        }
+        start = clock::now();
+        next = ncp.ode_step(inputs, v);
+        benchmark::DoNotOptimize(next);
+        ncp_seconds += std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    double crossover = 1.0;
+    for (size_t d = 0; d < densities.size(); ++d) {
+        if (sparse_seconds[d] < dense_seconds) continue;
+        if (d == 0) {
+            crossover = 0.0;
+            break;
+        }
+        double slower = sparse_seconds[d] - sparse_seconds[d - 1];
+        double t = slower > 0.0 ? (dense_seconds - sparse_seconds[d - 1]) / slower : 0.0;
+        crossover = densities[d - 1] + t * (densities[d] - densities[d - 1]);
+        break;
+    }
+    const double iterations = static_cast<double>(state.iterations());
+    state.counters["crossover_density"] = crossover;
+    state.counters["dense_us"] = dense_seconds / iterations * 1e6;
+    state.counters["ncp_edges"] = static_cast<double>(ncp.num_edges());
+    state.counters["ncp_density"] = static_cast<double>(ncp.num_edges()) / (static_cast<double>(units) * units);
+    state.counters["ncp_speedup"] = dense_seconds / ncp_seconds;
+    for (size_t d = 0; d < densities.size(); ++d) {
+        std::string percent = std::to_string(static_cast<int>(densities[d] * 100));
+        state.counters["speedup_" + std::string(3 - percent.size(), '0') + percent + "%"] = dense_seconds / sparse_seconds[d];
+    }
+}
+BENCHMARK(BM_SparseCrossover)->Arg(16)->Arg(64)->Arg(128)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond);
+
+// fused trio with 6 unfolds, arg 1: 0 = fixed, 1 = ODESolver::Adaptive. Arg 2 is the
+// starting state: 0 = settled (the fixed point, a quiet month), 1 = far from it (zero)
+static void BM_AdaptiveLTCStep(benchmark::State& state) {
+    const int units = static_cast<int>(state.range(0));
+    LTCCell accounting(units, 9), market(units, 8);
+    FusedLTCExecutor fused({ &accounting, &market });
+    std::vector<double> v(fused.total_units, 0.0), out(fused.total_units);
+    if (state.range(2) == 0) {
+        for (int i = 0; i < 200; ++i) fused.step(v.data(), v.data());
+    }
+    if (state.range(1) == 1) {
+        accounting.solver = market.solver = ODESolver::Adaptive;
+        fused.pack({ &accounting, &market });
+    }
+    for (auto _ : state) {
+        fused.step(v.data(), out.data());
+        benchmark::DoNotOptimize(out);
+    }
+    state.counters["evaluations"] = state.range(1) == 1 ? fused.ode_stats.evaluations_per_call() : fused.ode_solver_unfolds;
+}
+BENCHMARK(BM_AdaptiveLTCStep)->ArgsProduct({ { 16, 64 }, { 0, 1 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,46 @@
+// Scoring (encode + head) of every row; args are units per LTC cell, 0 = fp64 / 1 = int8
+#include "Bench.h"
+#include "BenchData.h"
+#include "BinaryDataset.h"
+#include "DataPreprocessing.h"
+#include "Quantized.h"
+#include <numeric>
+
+static void BM_ScoreRows(benchmark::State& state) {
+    BenchDataset files(200, 10, false, true);
+    std::vector<MacroData> macro;
+    std::vector<FinancialData> data = loadFinancialDataBinary(files.binary_path, macro);
+    normalizeData(data, macro);
+    const int units = static_cast<int>(state.range(0));
+    const bool int8 = state.range(1) == 1;
+
+    PortfolioModel model(units, units, units);
+    std::vector<size_t> rows(data.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    QuantizedPortfolioModel quantized(model);
+    quantized.calibrate(model, data, macro, rows);
+
+    std::vector<double> macro_outputs, combined_output(model.combined_output_size()), probs(PortfolioModel::num_actions);
+    for (auto _ : state) {
+        double sum = 0.0;
+        if (int8) {
+            quantized.encode_months(macro, macro_outputs);
+            for (const auto& fd : data) {
+                quantized.encode(fd, macro_outputs, combined_output.data());
+                quantized.action_probs(combined_output.data(), probs.data());
+                sum += probs[0];
+            }
+        }
+        else {
+            model.encode_months(macro, macro_outputs);
+            for (const auto& fd : data) {
+                model.encode(fd, macro_outputs, combined_output.data());
+                model.action_probs(combined_output.data(), probs.data());
+                sum += probs[0];
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ScoreRows)->ArgsProduct({ { 5, 32, 128 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,36 @@
+// Epoch setup + one pass over the rows in epoch order; args are symbols, years, mode
+// (0 = std::shuffle of the records, 1 = EpochOrder permutation, 2 = EpochOrder blocks of 64)
+#include "Bench.h"
+#include "BenchData.h"
+#include "BinaryDataset.h"
+#include "EpochOrder.h"
+#include <random>
+
+static void BM_EpochShuffle(benchmark::State& state) {
+    BenchDataset files(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    std::vector<MacroData> macro;
+    std::vector<FinancialData> data = loadFinancialDataBinary(files.binary_path, macro);
+    const int mode = static_cast<int>(state.range(2));
+
+    std::mt19937 g(42);
+    RngStream rng(42, 0);
+    EpochOrder order(data.size(), mode == 2 ? 64 : 0);
+    for (auto _ : state) {
+        double sum = 0.0;
+        if (mode == 0) {
+            std::shuffle(data.begin(), data.end(), g);
+            for (const auto& fd : data) sum += fd.stockPrice * fd.roa;
+        }
+        else {
+            order.shuffle(rng);
+            for (size_t k = 0; k < order.size(); ++k) {
+                order.prefetch(data, k);
+                const FinancialData& fd = data[order[k]];
+                sum += fd.stockPrice * fd.roa;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_EpochShuffle)->ArgsProduct({ { 2000 }, { 20 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,42 @@
+// One pass over a binary dataset, args are symbols, years, chunk rows
+// (0 = load, impute and normalize in memory, else StreamingDataset chunks of that many rows)
+#include "Bench.h"
+#include "BenchData.h"
+#include "BinaryDataset.h"
+#include "StreamingDataset.h"
+
+static void BM_StreamEpoch(benchmark::State& state) {
+    BenchDataset files(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), false, true);
+    const size_t chunk_rows = static_cast<size_t>(state.range(2));
+    StreamingOptions options;
+    options.chunk_rows = chunk_rows ? chunk_rows : 1;
+    StreamingDataset stream(files.binary_path, options);
+
+    size_t rows = 0;
+    for (auto _ : state) {
+        double sum = 0.0;
+        rows = 0;
+        if (chunk_rows == 0) {
+            std::vector<MacroData> macro;
+            DataValidity validity;
+            std::vector<FinancialData> data = loadFinancialDataBinary(files.binary_path, macro, validity);
+            imputeMissing(data, macro, validity);
+            normalizeData(data, macro, validity);
+            for (const auto& fd : data) sum += fd.stockPrice * fd.roa;
+            rows = data.size();
+        }
+        else {
+            stream.start_epoch();
+            while (const StreamChunk* chunk = stream.next_chunk()) {
+                for (size_t k = 0; k < chunk->order.size(); ++k) {
+                    const FinancialData& fd = chunk->rows[chunk->order[k]];
+                    sum += fd.stockPrice * fd.roa;
+                }
+                rows += chunk->rows.size();
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_StreamEpoch)->ArgsProduct({ { 2000 }, { 20 }, { 0, 4096, 65536 } })->Unit(benchmark::kMillisecond);
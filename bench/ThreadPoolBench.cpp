@@ -0,0 +1,31 @@
+// Dispatch cost of a small parallel loop; arg 0 = std::threads spawned per call (the
+// previous parallelFor), 1 = tasks on the shared ThreadPool
+#include "Bench.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cmath>
+
+static void BM_ParallelLoop(benchmark::State& state) {
+    const size_t count = 4096;
+    const int threads = 4;
+    std::vector<double> values(count);
+    auto body = [&](size_t i) { values[i] = std::sqrt(static_cast<double>(i)); };
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            std::atomic<size_t> next{ 0 };
+            auto worker = [&] {
+                for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) body(i);
+            };
+            std::vector<std::thread> workers;
+            for (int w = 1; w < threads; ++w) workers.emplace_back(worker);
+            worker();
+            for (auto& w : workers) w.join();
+        }
+        else {
+            parallelFor(count, threads, body, 256);
+        }
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ParallelLoop)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
@@ -1,87 +1,19 @@
+#include "Collector.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
-#include <curl/curl.h>
 #include <nlohmann/json.hpp>
 #include <cmath>
 #include <chrono>
 #include <thread>
 #include <ctime>
 #include <iomanip>
-#include <map>
 #include <algorithm>
 #include <numeric>
 #include <sstream>
 #include <cstdio>
 
-size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
-{
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
-
-std::string httpGet(const std::string& url)
-{
-    CURL* curl;
-    CURLcode res;
-    std::string readBuffer;
-
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
-    if (curl)
-    {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-
-        // Set a user agent to avoid being blocked by some servers
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0");
-
-        res = curl_easy_perform(curl);
-        if (res != CURLE_OK)
-            std::cerr << "cURL error: " << curl_easy_strerror(res) << std::endl;
-        curl_easy_cleanup(curl);
-    }
-    curl_global_cleanup();
-    return readBuffer;
-}
-
-// Function to get list of months covering the last 'years' years
-std::vector<std::string> getMonthsSince(int years)
-{
-    std::vector<std::string> months;
-
-    std::time_t t = std::time(nullptr);
-    std::tm now = *std::localtime(&t);
-
-    // Calculate the start date (years ago)
-    std::tm startDate = now;
-    startDate.tm_year -= years;
-    mktime(&startDate);
-
-    // Loop from startDate to now, adding each month to the list
-    std::tm current = startDate;
-    while ((current.tm_year < now.tm_year) || (current.tm_year == now.tm_year && current.tm_mon <= now.tm_mon))
-    {
-        char buffer[7];
-        std::strftime(buffer, sizeof(buffer), "%Y%m", &current);
-        months.push_back(buffer);
-
-        // Move to next month
-        current.tm_mon += 1;
-        if (current.tm_mon > 11)
-        {
-            current.tm_mon = 0;
-            current.tm_year += 1;
-        }
-        mktime(&current);
-    }
-
-    return months;
-}
-
 int main()
 {
     const std::string alphaVantageApiKey = "YOUR_ALPHA_VANTAGE_API_KEY";
@@ -112,14 +44,14 @@ int main()
         << "Sales Figures,Gross Margin,Self Financing Capacity,Net Income,Profit Per Stock,Free Cash Flow,"
         << "Net Debt to Equity,ROA,EBITDA,Pricing DCF,Sharpe Ratio,CAGR,VaR,CVaR,Beta,Dividend Yield\n";
 
-    // Generate list of months covering the last 5 years
+    // Months covering the last 5 years, every series below is indexed by period in it
     int years = 5;
-    std::vector<std::string> lastMonths = getMonthsSince(years);
+    Calendar calendar = calendarSince(years);
 
     // Calculate earliest date string in format "YYYY-MM-DD"
     std::time_t currentTime = std::time(nullptr);
     std::tm earliestDateTm;
-    localtime_s(&earliestDateTm, &currentTime);
+    localTime(currentTime, earliestDateTm);
 
     earliestDateTm.tm_year -= years;
     earliestDateTm.tm_mon = 0; // January
@@ -131,11 +63,11 @@ int main()
     std::string earliestDate = earliestDateBuffer;
 
     // Fetch Economic Indicators Once
-    std::map<std::string, double> interestRates;
-    std::map<std::string, double> unemploymentRates;
-    std::map<std::string, double> inflations;
-    std::map<std::string, double> growthRates;
-    std::map<std::string, double> consumerSentiments;
+    MonthlySeries interestRates(calendar);
+    MonthlySeries unemploymentRates(calendar);
+    MonthlySeries inflations(calendar);
+    MonthlySeries growthRates(calendar);
+    MonthlySeries consumerSentiments(calendar);
 
     // Fetch Interest Rate data
     {
@@ -163,13 +95,10 @@ int main()
                 {
                     std::string date = obs["date"].get<std::string>(); // Format: YYYY-MM-DD
                     std::string value = obs["value"].get<std::string>();
-                    if (value != ".")
+                    int month;
+                    if (value != "." && parseMonth(date, month))
                     {
-                        std::string month = date.substr(0, 4) + date.substr(5, 2);
-                        if (std::find(lastMonths.begin(), lastMonths.end(), month) != lastMonths.end())
-                        {
-                            interestRates[month] = std::stod(value);
-                        }
+                        interestRates.set_month(month, std::stod(value));
                     }
                 }
             }
@@ -202,13 +131,10 @@ int main()
                 {
                     std::string date = obs["date"].get<std::string>(); // Format: YYYY-MM-DD
                     std::string value = obs["value"].get<std::string>();
-                    if (value != ".")
+                    int month;
+                    if (value != "." && parseMonth(date, month))
                     {
-                        std::string month = date.substr(0, 4) + date.substr(5, 2);
-                        if (std::find(lastMonths.begin(), lastMonths.end(), month) != lastMonths.end())
-                        {
-                            unemploymentRates[month] = std::stod(value);
-                        }
+                        unemploymentRates.set_month(month, std::stod(value));
                     }
                 }
             }
@@ -220,7 +146,7 @@ int main()
         // Fetch CPI data
         std::string fredUrl = "https://api.stlouisfed.org/fred/series/observations?series_id=CPIAUCSL&api_key=" + fredApiKey + "&file_type=json&frequency=m&aggregation_method=avg&observation_start=" + earliestDate;
         std::string data = httpGet(fredUrl);
-        std::map<std::string, double> cpiData;
+        MonthlySeries cpiData(calendar.extended_back(12));
         if (data.empty())
         {
             std::cerr << "Failed to fetch CPI data." << std::endl;
@@ -243,29 +169,21 @@ int main()
                 {
                     std::string date = obs["date"].get<std::string>();
                     std::string value = obs["value"].get<std::string>();
-                    if (value != ".")
+                    int month;
+                    if (value != "." && parseMonth(date, month))
                     {
-                        std::string month = date.substr(0, 4) + date.substr(5, 2);
-                        cpiData[month] = std::stod(value);
+                        cpiData.set_month(month, std::stod(value));
                     }
                 }
 
-                // Calculate YoY Inflation
-                for (const auto& month : lastMonths)
+                // Calculate YoY Inflation, cpiData starts 12 months before the calendar
+                for (int period = 0; period < calendar.num_months; ++period)
                 {
-                    int year = std::stoi(month.substr(0, 4));
-                    int mon = std::stoi(month.substr(4, 2));
-
-                    int lastYear = year - 1;
-                    char lastYearBuffer[7];
-                    snprintf(lastYearBuffer, sizeof(lastYearBuffer), "%04d%02d", lastYear, mon);
-                    std::string lastYearMonth = lastYearBuffer;
-
-                    if (cpiData.count(month) && cpiData.count(lastYearMonth))
+                    if (cpiData.has(period + 12) && cpiData.has(period))
                     {
-                        double currentCPI = cpiData[month];
-                        double lastYearCPI = cpiData[lastYearMonth];
-                        inflations[month] = ((currentCPI - lastYearCPI) / lastYearCPI) * 100.0;
+                        double currentCPI = cpiData.get(period + 12, 0.0);
+                        double lastYearCPI = cpiData.get(period, 0.0);
+                        inflations.set(period, ((currentCPI - lastYearCPI) / lastYearCPI) * 100.0);
                     }
                 }
             }
@@ -294,35 +212,26 @@ int main()
             }
             else
             {
-                std::map<std::string, double> gdpData;
+                // keyed by the first month of each quarter
+                MonthlySeries gdpData(calendar.extended_back(2));
                 for (auto& obs : jsonData["observations"])
                 {
                     std::string date = obs["date"].get<std::string>();
                     std::string value = obs["value"].get<std::string>();
-                    if (value != ".")
+                    int quarter;
+                    if (value != "." && parseMonth(date, quarter))
                     {
-                        std::string quarter = date.substr(0, 7);
-                        gdpData[quarter] = std::stod(value);
+                        gdpData.set_month(quarter, std::stod(value));
                     }
                 }
-                // Map quarterly data to months in lastMonths
-                for (const auto& month : lastMonths)
+                // Map quarterly data to months of the calendar
+                for (int period = 0; period < calendar.num_months; ++period)
                 {
-                    std::string year = month.substr(0, 4);
-                    std::string mon = month.substr(4, 2);
-                    int monInt = std::stoi(mon);
-                    std::string quarter;
-                    if (monInt <= 3)
-                        quarter = year + "-01";
-                    else if (monInt <= 6)
-                        quarter = year + "-04";
-                    else if (monInt <= 9)
-                        quarter = year + "-07";
-                    else
-                        quarter = year + "-10";
-                    if (gdpData.count(quarter))
+                    int month = calendar.month(period);
+                    int quarter = month - (monthOfYear(month) - 1) % 3;
+                    if (gdpData.has_month(quarter))
                     {
-                        growthRates[month] = gdpData[quarter];
+                        growthRates.set(period, gdpData.at_month(quarter));
                     }
                 }
             }
@@ -355,13 +264,10 @@ int main()
                 {
                     std::string date = obs["date"].get<std::string>();
                     std::string value = obs["value"].get<std::string>();
-                    if (value != ".")
+                    int month;
+                    if (value != "." && parseMonth(date, month))
                     {
-                        std::string month = date.substr(0, 4) + date.substr(5, 2);
-                        if (std::find(lastMonths.begin(), lastMonths.end(), month) != lastMonths.end())
-                        {
-                            consumerSentiments[month] = std::stod(value);
-                        }
+                        consumerSentiments.set_month(month, std::stod(value));
                     }
                 }
             }
@@ -369,7 +275,7 @@ int main()
     }
 
     // Fetch Sector Sentiment data once
-    std::map<std::string, double> sectorSentiments;
+    MonthlySeries sectorSentiments(calendar);
     {
         std::string sectorSymbol = "XLK"; // Technology Select Sector SPDR Fund
         std::string url = "https://www.alphavantage.co/query?function=TIME_SERIES_MONTHLY_ADJUSTED&symbol=" + sectorSymbol + "&apikey=" + alphaVantageApiKey;
@@ -393,37 +299,33 @@ int main()
             else if (jsonData.contains("Monthly Adjusted Time Series"))
             {
                 auto timeSeries = jsonData["Monthly Adjusted Time Series"];
-                std::map<std::string, double> sectorPrices;
-                std::vector<std::string> months;
+                MonthlySeries sectorPrices(calendar);
                 for (auto& item : timeSeries.items())
                 {
                     std::string dateStr = item.key(); // format: YYYY-MM-DD
-                    std::string month = dateStr.substr(0, 4) + dateStr.substr(5, 2);
-                    if (std::find(lastMonths.begin(), lastMonths.end(), month) != lastMonths.end())
+                    int month;
+                    if (parseMonth(dateStr, month))
                     {
                         double adjustedClose = std::stod(item.value()["5. adjusted close"].get<std::string>());
-                        sectorPrices[month] = adjustedClose;
-                        months.push_back(month);
+                        sectorPrices.set_month(month, adjustedClose);
                     }
                 }
-                std::sort(months.begin(), months.end());
-                for (size_t i = 1; i < months.size(); ++i)
+                // change since the previous month with a price, 0 for the first one
+                int prevPeriod = -1;
+                for (int period = 0; period < calendar.num_months; ++period)
                 {
-                    const std::string& currentMonth = months[i];
-                    const std::string& prevMonth = months[i - 1];
-                    if (sectorPrices.count(currentMonth) && sectorPrices.count(prevMonth))
-                    {
-                        double currentPrice = sectorPrices[currentMonth];
-                        double prevPrice = sectorPrices[prevMonth];
-                        double change = ((currentPrice - prevPrice) / prevPrice) * 100.0;
-                        sectorSentiments[currentMonth] = change;
-                    }
-                    else
+                    if (!sectorPrices.has(period))
+                        continue;
+                    double change = 0.0;
+                    if (prevPeriod >= 0)
                     {
-                        sectorSentiments[currentMonth] = 0.0;
+                        double currentPrice = sectorPrices.get(period, 0.0);
+                        double prevPrice = sectorPrices.get(prevPeriod, 0.0);
+                        change = ((currentPrice - prevPrice) / prevPrice) * 100.0;
                     }
+                    sectorSentiments.set(period, change);
+                    prevPeriod = period;
                 }
-                sectorSentiments[months[0]] = 0.0;
             }
             else
             {
@@ -438,8 +340,7 @@ int main()
     {
         std::cout << "Processing: " << symbol << std::endl;
 
-        std::map<std::string, double> stockPrices;
-        std::vector<std::string> availableMonths;
+        MonthlySeries stockPrices(calendar);
         {
             std::string url = "https://www.alphavantage.co/query?function=TIME_SERIES_MONTHLY_ADJUSTED&symbol=" + symbol + "&apikey=" + alphaVantageApiKey;
             std::string data = httpGet(url);
@@ -465,12 +366,11 @@ int main()
                     for (auto& item : timeSeries.items())
                     {
                         std::string dateStr = item.key(); // format: YYYY-MM-DD
-                        std::string month = dateStr.substr(0, 4) + dateStr.substr(5, 2);
-                        if (std::find(lastMonths.begin(), lastMonths.end(), month) != lastMonths.end())
+                        int month;
+                        if (parseMonth(dateStr, month))
                         {
                             double adjustedClose = std::stod(item.value()["5. adjusted close"].get<std::string>());
-                            stockPrices[month] = adjustedClose;
-                            availableMonths.push_back(month);
+                            stockPrices.set_month(month, adjustedClose);
                         }
                     }
                 }
@@ -666,15 +566,8 @@ int main()
         {
             std::time_t t = std::time(nullptr);
             std::tm now;
-            localtime_s(&now, &t);
-            std::tm startDateTm = now;
-
-            startDateTm.tm_year -= years;
-            mktime(&startDateTm);
-
-            char startDateBuffer[11];
-            std::strftime(startDateBuffer, sizeof(startDateBuffer), "%Y-%m-%d", &startDateTm);
-            std::string startDate = startDateBuffer;
+            localTime(t, now);
+            int startDay = dayIndex(now.tm_year + 1900 - years, now.tm_mon + 1, now.tm_mday);
 
 
             std::string url = "https://www.alphavantage.co/query?function=TIME_SERIES_DAILY_ADJUSTED&symbol=" + symbol + "&outputsize=full&apikey=" + alphaVantageApiKey;
@@ -701,7 +594,8 @@ int main()
                     for (auto it = timeSeries.begin(); it != timeSeries.end(); ++it)
                     {
                         std::string dateStr = it.key(); // format: YYYY-MM-DD
-                        if (dateStr >= startDate)
+                        int day;
+                        if (parseDay(dateStr, day) && day >= startDay)
                         {
                             double adjustedClose = std::stod(it.value()["5. adjusted close"].get<std::string>());
                             historicalPrices.push_back(adjustedClose);
@@ -744,8 +638,9 @@ int main()
 
             // Use the latest available interest rate as risk-free rate
             double riskFreeRate = 0.0;
-            if (!interestRates.empty())
-                riskFreeRate = interestRates.rbegin()->second / 100.0;
+            int latest = interestRates.last_valid();
+            if (latest >= 0)
+                riskFreeRate = interestRates.get(latest, 0.0) / 100.0;
             if (annualizedStdDev != 0)
                 sharpeRatio = (annualizedReturn - riskFreeRate) / annualizedStdDev;
 
@@ -764,26 +659,27 @@ int main()
 
         double pricingDCF = 0.0; // Placeholder for DCF calculation
 
-        // Write data to CSV for each month in lastMonths
-        for (const auto& month : lastMonths)
+        // Write data to CSV for each month of the calendar
+        // months a series has no value for are written as NA, the loader keeps them missing
+        auto writeValue = [&](const MonthlySeries& series, int period) -> std::ostream&
+        {
+            if (series.has(period))
+                csvFile << series.get(period, 0.0);
+            else
+                csvFile << "NA";
+            return csvFile << ",";
+        };
+        for (int period = 0; period < calendar.num_months; ++period)
         {
-            double stockPrice = stockPrices.count(month) ? stockPrices[month] : 0.0;
-            double interestRate = interestRates.count(month) ? interestRates[month] : 0.0;
-            double unemploymentRate = unemploymentRates.count(month) ? unemploymentRates[month] : 0.0;
-            double inflation = inflations.count(month) ? inflations[month] : 0.0;
-            double growthRate = growthRates.count(month) ? growthRates[month] : 0.0;
-            double consumerSentiment = consumerSentiments.count(month) ? consumerSentiments[month] : 0.0;
-            double sectorSentiment = sectorSentiments.count(month) ? sectorSentiments[month] : 0.0;
-
-            csvFile << month << ","
-                << symbol << ","
-                << stockPrice << ","
-                << interestRate << ","
-                << unemploymentRate << ","
-                << inflation << ","
-                << growthRate << ","
-                << consumerSentiment << ","
-                << sectorSentiment << ","
+            csvFile << calendar.date(period) << ","
+                << symbol << ",";
+            writeValue(stockPrices, period);
+            writeValue(interestRates, period);
+            writeValue(unemploymentRates, period);
+            writeValue(inflations, period);
+            writeValue(growthRates, period);
+            writeValue(consumerSentiments, period);
+            writeValue(sectorSentiments, period)
                 << salesFigures << ","
                 << grossMargin << ","
                 << selfFinancingCapacity << ","
@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ctime>
+#include "Calendar.h"
+
+// HTTP GET through libcurl, returns the body (empty on error)
+std::string httpGet(const std::string& url);
+
+// every month from 'years' years ago to now
+Calendar calendarSince(int years);
+
+void localTime(std::time_t t, std::tm& out);
@@ -0,0 +1,60 @@
+#include "Collector.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <curl/curl.h>
+#include <ctime>
+
+static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    ((std::string*)userp)->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+std::string httpGet(const std::string& url)
+{
+    CURL* curl;
+    CURLcode res;
+    std::string readBuffer;
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    curl = curl_easy_init();
+    if (curl)
+    {
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+
+        // Set a user agent to avoid being blocked by some servers
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0");
+
+        res = curl_easy_perform(curl);
+        if (res != CURLE_OK)
+            std::cerr << "cURL error: " << curl_easy_strerror(res) << std::endl;
+        curl_easy_cleanup(curl);
+    }
+    curl_global_cleanup();
+    return readBuffer;
+}
+
+// Calendar covering the last 'years' years, this month included
+Calendar calendarSince(int years)
+{
+    std::time_t t = std::time(nullptr);
+    std::tm now;
+    localTime(t, now);
+
+    int thisMonth = monthIndex(now.tm_year + 1900, now.tm_mon + 1);
+    return Calendar(thisMonth - years * 12, thisMonth);
+}
+
+// localtime_s is MSVC-only (and has its arguments swapped in C11 Annex K)
+void localTime(std::time_t t, std::tm& out)
+{
+#ifdef _WIN32
+    localtime_s(&out, &t);
+#else
+    localtime_r(&t, &out);
+#endif
+}
@@ -0,0 +1,342 @@
+#include "SyntheticGenerator.h"
+#include "BinaryDataset.h"
+#include "ExplorationPolicy.h"
+#include "FeatureSchema.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+enum Regime { Expansion, Slowdown, Recession, NumRegimes };
+
+struct RegimeParams {
+    double market_drift;  // monthly log return
+    double market_vol;
+    double idiosyncratic_scale;
+    // levels the macro series revert to
+    double interest_rate;
+    double unemployment_rate;
+    double inflation;
+    double growth_rate;
+    double consumer_sentiment;
+};
+
+const RegimeParams regimes[NumRegimes] = {
+    { 0.008, 0.035, 1.0, 4.0, 4.5, 2.0, 3.0, 95.0 },
+    { 0.002, 0.050, 1.2, 5.0, 5.5, 3.5, 1.0, 85.0 },
+    { -0.015, 0.080, 1.5, 2.0, 8.5, 1.0, -2.0, 65.0 },
+};
+
+// monthly transition probabilities, rows = from
+const double transition[NumRegimes][NumRegimes] = {
+    { 0.970, 0.025, 0.005 },
+    { 0.060, 0.900, 0.040 },
+    { 0.050, 0.100, 0.850 },
+};
+
+// everything shared by the symbols, simulated once
+struct Economy {
+    int num_periods = 0;
+    int num_sectors = 0;
+    std::vector<MacroData> macro;
+    std::vector<double> market;            // factor return per period
+    std::vector<double> sector;            // [periods x sectors] factor returns
+    std::vector<double> sector_sentiment;  // [periods x sectors] EMA of sector returns
+    std::vector<int> regime;
+};
+
+Economy simulateEconomy(const GeneratorConfig& config) {
+    Economy eco;
+    eco.num_periods = config.num_years * 12;
+    eco.num_sectors = std::max(1, config.num_sectors);
+    eco.macro.resize(eco.num_periods);
+    eco.market.resize(eco.num_periods);
+    eco.sector.resize(eco.num_periods * eco.num_sectors);
+    eco.sector_sentiment.resize(eco.num_periods * eco.num_sectors);
+    eco.regime.resize(eco.num_periods);
+
+    RngStream rng(config.seed, 0);
+    int regime = Expansion;
+    MacroData level{ "", 4.0, 4.5, 2.0, 3.0, 95.0 };
+    std::vector<double> sentiment(eco.num_sectors, 0.0);
+    char date[16];
+    for (int t = 0; t < eco.num_periods; ++t) {
+        double u = rng.uniform();
+        int next = 0;
+        while (next < NumRegimes - 1 && u > transition[regime][next]) u -= transition[regime][next++];
+        regime = next;
+        const RegimeParams& p = regimes[regime];
+        eco.regime[t] = regime;
+
+        // AR(1) pull toward the regime's levels
+        auto revert = [&](double& x, double target, double speed, double noise) {
+            x += speed * (target - x) + noise * rng.normal();
+        };
+        revert(level.interestRate, p.interest_rate, 0.05, 0.10);
+        revert(level.unemploymentRate, p.unemployment_rate, 0.08, 0.10);
+        revert(level.inflation, p.inflation, 0.08, 0.15);
+        revert(level.growthRate, p.growth_rate, 0.15, 0.30);
+        revert(level.consumerSentiment, p.consumer_sentiment, 0.15, 2.0);
+        level.interestRate = std::max(0.0, level.interestRate);
+        level.unemploymentRate = std::max(1.0, level.unemploymentRate);
+
+        std::snprintf(date, sizeof(date), "%04d%02d", config.start_year + t / 12, t % 12 + 1);
+        eco.macro[t] = level;
+        eco.macro[t].date = date;
+
+        eco.market[t] = p.market_drift + p.market_vol * rng.normal();
+        for (int g = 0; g < eco.num_sectors; ++g) {
+            double r = 0.03 * p.idiosyncratic_scale * rng.normal();
+            eco.sector[t * eco.num_sectors + g] = r;
+            sentiment[g] = 0.8 * sentiment[g] + 0.2 * (r + eco.market[t]) * 10.0;
+            eco.sector_sentiment[t * eco.num_sectors + g] = sentiment[g];
+        }
+    }
+    return eco;
+}
+
+// [periods x row fields] for one symbol, fields in binaryRowFields() order
+void simulateSymbol(const Economy& eco, const GeneratorConfig& config, int s,
+    const std::vector<const FeatureField*>& fields, double* out) {
+    RngStream rng(config.seed + 0x9e3779b97f4a7c15ULL * static_cast<uint64_t>(s + 1), 0);
+    const int sector = s % eco.num_sectors;
+    const double beta = 0.5 + rng.uniform();
+    const double loading = 0.5 + 0.5 * rng.uniform();
+    const double idiosyncratic = 0.04 + 0.08 * rng.uniform();
+    const double alpha = 0.002 * rng.normal();
+    const double gross_base = 0.2 + 0.4 * rng.uniform();
+    const double opex = 0.1 + 0.15 * rng.uniform();
+    const double dividend = 0.05 * rng.uniform();
+    double price = 50.0 * std::exp(0.8 * rng.normal());
+    double sales = 1e8 * std::exp(1.5 * rng.normal());                 // monthly
+    const double shares = sales * 12.0 * (1.0 + rng.uniform()) / price;  // cap ~ 1-2x annual sales
+    double gross = gross_base;
+    double leverage = 1.5 * rng.uniform();
+
+    // trailing 12 months of returns for the risk columns
+    double window[12] = {};
+    int filled = 0;
+    double sum = 0.0, sum_sq = 0.0;
+
+    FinancialData fd{};
+    const size_t F = fields.size();
+    for (int t = 0; t < eco.num_periods; ++t) {
+        const MacroData& m = eco.macro[t];
+        const RegimeParams& p = regimes[eco.regime[t]];
+        if (t > 0) {
+            double r = alpha + beta * eco.market[t] + loading * eco.sector[t * eco.num_sectors + sector]
+                + idiosyncratic * p.idiosyncratic_scale * rng.normal();
+            price = std::max(0.01, price * std::exp(r));
+            double& slot = window[t % 12];
+            if (filled == 12) {
+                sum -= slot;
+                sum_sq -= slot * slot;
+            }
+            else {
+                ++filled;
+            }
+            slot = r;
+            sum += r;
+            sum_sq += r * r;
+        }
+        sales *= std::exp(m.growthRate / 1200.0 + 0.03 * rng.normal());
+        gross += 0.1 * (gross_base - gross) + 0.01 * rng.normal();
+        leverage = std::max(0.0, leverage + 0.02 * rng.normal());
+
+        double mean = filled ? sum / filled : 0.0;
+        double sd = filled ? std::sqrt(std::max(0.0, sum_sq / filled - mean * mean)) : 0.0;
+
+        fd.stockPrice = price;
+        fd.sectorSentiment = eco.sector_sentiment[t * eco.num_sectors + sector];
+        fd.salesFigures = sales;
+        fd.grossMargin = gross;
+        fd.netIncome = sales * (gross - opex);
+        fd.selfFinancingCapacity = fd.netIncome + 0.05 * sales;
+        fd.profitPerStock = fd.netIncome * 12.0 / shares;
+        fd.freeCashFlow = fd.selfFinancingCapacity - sales * (0.03 + 0.01 * rng.uniform());
+        fd.netDebtToEquity = leverage;
+        fd.roa = fd.netIncome / (sales * 1.2);
+        fd.ebitda = fd.netIncome + 0.08 * sales;
+        fd.pricingDCF = price * std::exp(0.15 * rng.normal());
+        fd.sharpeRatio = sd > 0.0 ? mean / sd * std::sqrt(12.0) : 0.0;
+        fd.cagr = std::exp(12.0 * mean) - 1.0;
+        fd.var = -(mean - 1.645 * sd);
+        fd.cvar = -(mean - 2.063 * sd);
+        fd.beta = beta + 0.1 * rng.normal();
+        fd.dividendYield = std::max(0.0, dividend + 0.002 * rng.normal());
+
+        for (size_t f = 0; f < F; ++f) {
+            out[t * F + f] = fd.*(fields[f]->row);
+        }
+    }
+}
+
+std::string symbolName(int s, int width) {
+    std::string digits = std::to_string(s);
+    return "S" + std::string(std::max(0, width - static_cast<int>(digits.size())), '0') + digits;
+}
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+} // namespace
+
+bool generateSyntheticDataset(const GeneratorConfig& config, GeneratorStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    const Economy eco = simulateEconomy(config);
+    const int num_symbols = config.num_symbols;
+    const int periods = eco.num_periods;
+    const int width = static_cast<int>(std::to_string(std::max(0, num_symbols - 1)).size());
+    const std::vector<const FeatureField*> row_fields = binaryRowFields();
+    const std::vector<const FeatureField*> macro_fields = binaryMacroFields();
+    const size_t F = row_fields.size();
+
+    // CSV columns in file order: index into the row block, or -1 - index into the macro row
+    std::vector<int> csv_columns;
+    std::string header_line = "Date,Symbol";
+    for (const FeatureField& field : featureSchema) {
+        if (!field.csv_column) continue;
+        header_line += std::string(",") + field.csv_column;
+        if (field.row) {
+            csv_columns.push_back(static_cast<int>(std::find(row_fields.begin(), row_fields.end(), &field) - row_fields.begin()));
+        }
+        else {
+            csv_columns.push_back(-1 - static_cast<int>(std::find(macro_fields.begin(), macro_fields.end(), &field) - macro_fields.begin()));
+        }
+    }
+    header_line += "\n";
+    std::vector<double> macro_values(periods * macro_fields.size());
+    for (int t = 0; t < periods; ++t) {
+        for (size_t f = 0; f < macro_fields.size(); ++f) {
+            macro_values[t * macro_fields.size() + f] = eco.macro[t].*(macro_fields[f]->macro);
+        }
+    }
+
+    std::ofstream csv;
+    if (!config.csv_path.empty()) {
+        csv.open(config.csv_path, std::ios::binary);
+        if (!csv.is_open()) {
+            std::cerr << "Failed to open CSV file: " << config.csv_path << std::endl;
+            return false;
+        }
+        csv << header_line;
+    }
+
+    // binary: everything but the rows up front, rows are filled in place by the workers
+    BinaryDatasetHeader header = makeBinaryDatasetHeader(num_symbols, periods);
+    if (!config.binary_path.empty()) {
+        std::ofstream binary(config.binary_path, std::ios::binary | std::ios::trunc);
+        if (!binary.is_open()) {
+            std::cerr << "Failed to open binary file: " << config.binary_path << std::endl;
+            return false;
+        }
+        binary.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        std::vector<char> table(periods * header.date_width, 0);
+        for (int t = 0; t < periods; ++t) {
+            eco.macro[t].date.copy(&table[t * header.date_width], header.date_width - 1);
+        }
+        binary.write(table.data(), table.size());
+        table.assign(static_cast<size_t>(num_symbols) * header.symbol_width, 0);
+        for (int s = 0; s < num_symbols; ++s) {
+            symbolName(s, width).copy(&table[s * header.symbol_width], header.symbol_width - 1);
+        }
+        binary.write(table.data(), table.size());
+        binary.write(reinterpret_cast<const char*>(macro_values.data()), macro_values.size() * sizeof(double));
+        binary.close();
+        std::filesystem::resize_file(config.binary_path, binaryDatasetSize(header));
+    }
+
+    const int block_symbols = std::max(1, config.block_symbols);
+    const int num_blocks = (num_symbols + block_symbols - 1) / block_symbols;
+    int threads = config.threads > 0 ? config.threads : ThreadPool::instance().concurrency();
+    threads = std::max(1, std::min(threads, num_blocks));
+
+    // CSV blocks are appended in symbol order, a worker waits for its turn
+    std::atomic<int> next_block{ 0 };
+    std::mutex csv_mutex;
+    std::condition_variable csv_turn;
+    int csv_block = 0;
+    std::atomic<bool> failed{ false };
+
+    auto worker = [&] {
+        std::fstream binary;
+        if (!config.binary_path.empty()) {
+            binary.open(config.binary_path, std::ios::in | std::ios::out | std::ios::binary);
+            if (!binary.is_open()) failed = true;
+        }
+        std::vector<double> rows;
+        std::string text;
+        for (int b = next_block.fetch_add(1); b < num_blocks; b = next_block.fetch_add(1)) {
+            int first = b * block_symbols;
+            int count = std::min(block_symbols, num_symbols - first);
+            rows.resize(static_cast<size_t>(count) * periods * F);
+            for (int i = 0; i < count; ++i) {
+                simulateSymbol(eco, config, first + i, row_fields, &rows[static_cast<size_t>(i) * periods * F]);
+            }
+
+            if (binary.is_open()) {
+                binary.seekp(binaryRowOffset(header, first, 0));
+                binary.write(reinterpret_cast<const char*>(rows.data()), rows.size() * sizeof(double));
+                if (!binary) failed = true;
+            }
+
+            if (csv.is_open()) {
+                text.clear();
+                for (int i = 0; i < count; ++i) {
+                    std::string symbol = symbolName(first + i, width);
+                    for (int t = 0; t < periods; ++t) {
+                        const double* row = &rows[(static_cast<size_t>(i) * periods + t) * F];
+                        const double* macro_row = &macro_values[t * macro_fields.size()];
+                        text += eco.macro[t].date;
+                        text += ',';
+                        text += symbol;
+                        for (int column : csv_columns) {
+                            text += ',';
+                            appendNumber(text, column >= 0 ? row[column] : macro_row[-1 - column]);
+                        }
+                        text += '\n';
+                    }
+                }
+                std::unique_lock<std::mutex> lock(csv_mutex);
+                csv_turn.wait(lock, [&] { return csv_block == b; });
+                csv.write(text.data(), text.size());
+                ++csv_block;
+                csv_turn.notify_all();
+            }
+        }
+    };
+
+    TaskGroup workers;
+    for (int w = 1; w < threads; ++w) {
+        workers.run(worker);
+    }
+    worker();
+    workers.wait();
+
+    stats.rows = static_cast<uint64_t>(num_symbols) * periods;
+    if (csv.is_open()) {
+        csv.close();
+        stats.csv_bytes = std::filesystem::file_size(config.csv_path);
+    }
+    if (!config.binary_path.empty()) {
+        stats.binary_bytes = binaryDatasetSize(header);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failed) {
+        std::cerr << "Failed to write binary file: " << config.binary_path << std::endl;
+    }
+    return !failed;
+}
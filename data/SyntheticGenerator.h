@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Offline stand-in for the Collector: financial_data.csv-schema datasets of any size.
+// Macro series follow a Markov chain of economic regimes, prices follow a factor model
+// (market + sector + idiosyncratic) whose drift and volatility depend on the regime, and
+// the accounting and risk columns are derived from each symbol's own path.
+struct GeneratorConfig {
+    int num_symbols = 1000;
+    int num_years = 20;
+    int start_year = 1975;
+    int num_sectors = 11;
+    uint64_t seed = 42;
+    int threads = 0;           // 0 = all of the shared ThreadPool
+    int block_symbols = 64;    // symbols generated per task
+    std::string csv_path;      // empty = no CSV
+    std::string binary_path;   // empty = no binary (BinaryDataset.h format)
+};
+
+struct GeneratorStats {
+    uint64_t rows = 0;
+    uint64_t csv_bytes = 0;
+    uint64_t binary_bytes = 0;
+    double seconds = 0.0;
+};
+
+// Output only depends on the config (not on threads): every symbol draws from its own stream.
+bool generateSyntheticDataset(const GeneratorConfig& config, GeneratorStats& stats);